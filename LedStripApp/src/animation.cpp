@@ -0,0 +1,151 @@
+#include <cmath>
+#include <algorithm>
+
+#include "animation.h"
+
+namespace
+{
+    std::array<float, 3> rgb_to_hsv(const std::array<float, 3>& rgb)
+    {
+        const float max = std::max({ rgb[0], rgb[1], rgb[2] });
+        const float min = std::min({ rgb[0], rgb[1], rgb[2] });
+        const float delta = max - min;
+
+        float hue = 0.0f;
+        if (delta > 0.0f)
+        {
+            if (max == rgb[0])
+                hue = std::fmod((rgb[1] - rgb[2]) / delta + 6.0f, 6.0f);
+            else if (max == rgb[1])
+                hue = (rgb[2] - rgb[0]) / delta + 2.0f;
+            else
+                hue = (rgb[0] - rgb[1]) / delta + 4.0f;
+        }
+        return { hue / 6.0f, max > 0.0f ? delta / max : 0.0f, max };
+    }
+
+    std::array<float, 3> hsv_to_rgb(const std::array<float, 3>& hsv)
+    {
+        auto channel = [&hsv](float n)
+        {
+            const float k = std::fmod(n + hsv[0] * 6.0f, 6.0f);
+            return hsv[2] - hsv[2] * hsv[1] * std::clamp(std::min(k, 4.0f - k), 0.0f, 1.0f);
+        };
+        return { channel(5.0f), channel(3.0f), channel(1.0f) };
+    }
+}
+
+Animation::Animation(std::string name, const std::vector<Keyframe>& keyframes, bool loop)
+    : name(name), loop(loop), m_duration(0.0f), m_lut()
+{
+    std::vector<Keyframe> sorted = keyframes;
+    std::ranges::stable_sort(sorted, {}, &Keyframe::time);
+    if (sorted.empty())
+    {
+        sorted.push_back({ 0.0f, { 0.0f, 0.0f, 0.0f }, 0.0f });
+    }
+    m_duration = std::max(sorted.back().time, 0.001f);
+
+    // A looping table wraps around, so its last entry is one step before the end
+    const float step = m_duration / static_cast<float>(loop ? LUT_SIZE : LUT_SIZE - 1);
+    for (size_t i = 0; i < LUT_SIZE; i++)
+    {
+        const std::array<float, 3> color = evaluate(sorted, step * static_cast<float>(i));
+        for (size_t c = 0; c < 3; c++)
+        {
+            m_lut[i][c] = static_cast<uint8_t>(std::lround(std::clamp(color[c], 0.0f, 1.0f) * 255.0f));
+        }
+    }
+}
+
+std::array<float, 3> Animation::sample(float time) const
+{
+    const float position = (loop ? std::fmod(std::max(time, 0.0f), m_duration) : std::clamp(time, 0.0f, m_duration))
+        / m_duration * static_cast<float>(loop ? LUT_SIZE : LUT_SIZE - 1);
+    const size_t index = std::min(static_cast<size_t>(position), LUT_SIZE - 1);
+    const size_t next = loop ? (index + 1) % LUT_SIZE : std::min(index + 1, LUT_SIZE - 1);
+    const float fraction = position - static_cast<float>(index);
+
+    std::array<float, 3> color;
+    for (size_t c = 0; c < 3; c++)
+    {
+        color[c] = (m_lut[index][c] + (m_lut[next][c] - m_lut[index][c]) * fraction) / 255.0f;
+    }
+    return color;
+}
+
+std::array<float, 3> Animation::evaluate(const std::vector<Keyframe>& keyframes, float time)
+{
+    auto to = std::ranges::upper_bound(keyframes, time, {}, &Keyframe::time);
+    if (to == keyframes.begin() || to == keyframes.end())
+    {
+        const Keyframe& keyframe = to == keyframes.begin() ? keyframes.front() : keyframes.back();
+        return { keyframe.color[0] * keyframe.brightness, keyframe.color[1] * keyframe.brightness, keyframe.color[2] * keyframe.brightness };
+    }
+    const Keyframe& from = *(to - 1);
+
+    float t = (time - from.time) / std::max(to->time - from.time, 0.001f);
+    if (from.interpolation == Interpolation::EASE)
+    {
+        t = t * t * (3.0f - 2.0f * t);
+    }
+    const float brightness = from.brightness + (to->brightness - from.brightness) * t;
+
+    std::array<float, 3> color;
+    if (from.interpolation == Interpolation::HUE_SWEEP)
+    {
+        std::array<float, 3> hsv_from = rgb_to_hsv(from.color);
+        std::array<float, 3> hsv_to = rgb_to_hsv(to->color);
+        if (hsv_to[0] <= hsv_from[0])
+        {
+            hsv_to[0] += 1.0f; // Always sweep forward, the same hue on both ends is a full turn
+        }
+        std::array<float, 3> hsv;
+        for (size_t c = 0; c < 3; c++)
+        {
+            hsv[c] = hsv_from[c] + (hsv_to[c] - hsv_from[c]) * t;
+        }
+        hsv[0] = std::fmod(hsv[0], 1.0f);
+        color = hsv_to_rgb(hsv);
+    }
+    else
+    {
+        for (size_t c = 0; c < 3; c++)
+        {
+            color[c] = from.color[c] + (to->color[c] - from.color[c]) * t;
+        }
+    }
+
+    for (float& channel : color)
+    {
+        channel *= brightness;
+    }
+    return color;
+}
+
+std::vector<std::shared_ptr<const Animation>> Animation::presets()
+{
+    const std::array<float, 3> red = { 1.0f, 0.0f, 0.0f };
+    const std::array<float, 3> white = { 1.0f, 1.0f, 1.0f };
+    const std::array<float, 3> warm_white = { 1.0f, 0.75f, 0.45f };
+
+    return {
+        std::make_shared<const Animation>("Rainbow", std::vector<Keyframe>{
+            { 0.0f, red, 1.0f, Interpolation::HUE_SWEEP },
+            { 12.0f, red, 1.0f } }, true),
+        std::make_shared<const Animation>("Breathe", std::vector<Keyframe>{
+            { 0.0f, white, 0.05f, Interpolation::EASE },
+            { 2.0f, white, 1.0f, Interpolation::EASE },
+            { 4.0f, white, 0.05f } }, true),
+        std::make_shared<const Animation>("Candle", std::vector<Keyframe>{
+            { 0.0f, warm_white, 0.8f, Interpolation::EASE },
+            { 0.3f, warm_white, 0.6f, Interpolation::EASE },
+            { 0.5f, warm_white, 0.9f, Interpolation::EASE },
+            { 1.1f, warm_white, 0.7f, Interpolation::EASE },
+            { 1.4f, warm_white, 0.8f } }, true),
+        std::make_shared<const Animation>("Sunrise", std::vector<Keyframe>{
+            { 0.0f, { 0.6f, 0.05f, 0.0f }, 0.05f },
+            { 300.0f, { 1.0f, 0.4f, 0.05f }, 0.5f },
+            { 600.0f, warm_white, 1.0f } }, false)
+    };
+}
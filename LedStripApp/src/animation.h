@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+enum class Interpolation
+{
+	LINEAR = 0,
+	EASE = 1,     // Smoothstep in and out
+	HUE_SWEEP = 2 // Around the color wheel instead of straight through RGB
+};
+
+struct Keyframe
+{
+	float time; // Seconds from the start of the animation
+	std::array<float, 3> color;
+	float brightness;
+	Interpolation interpolation = Interpolation::LINEAR; // Towards the next keyframe
+};
+
+// Keyframed color/brightness curve. It is baked into a small lookup table once, so sampling it
+// costs the same per tick however many keyframes it has. Immutable, shared between controllers.
+class Animation
+{
+public:
+	explicit Animation(std::string name, const std::vector<Keyframe>& keyframes, bool loop);
+	~Animation() = default;
+
+	// Color with brightness applied, time in seconds since the animation started. Not rounded to
+	// 8 bit levels, so a dithering encoder can use the fraction between table entries.
+	std::array<float, 3> sample(float time) const;
+	inline bool is_finished(float time) const { return !loop && time >= m_duration; }
+	inline float duration() const { return m_duration; }
+
+	static std::vector<std::shared_ptr<const Animation>> presets();
+
+public:
+	const std::string name;
+	const bool loop;
+
+private:
+	static std::array<float, 3> evaluate(const std::vector<Keyframe>& keyframes, float time);
+
+	static constexpr size_t LUT_SIZE = 256;
+
+	float m_duration;
+	std::array<std::array<uint8_t, 3>, LUT_SIZE> m_lut;
+};
@@ -0,0 +1,98 @@
+#include <algorithm>
+
+#include "animation_player.h"
+#include "led_controller.h"
+
+AnimationPlayer::AnimationPlayer(BLEScheduler& scheduler)
+    : m_scheduler(scheduler), m_strand(scheduler.make_strand())
+{
+}
+
+AnimationPlayer::~AnimationPlayer()
+{
+    m_scheduler.close(m_strand); // A tick already waiting for its deadline is dropped
+}
+
+void AnimationPlayer::play(LEDController* controller, std::shared_ptr<const Animation> animation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const clock::time_point now = clock::now();
+    const auto playing = std::ranges::find(m_entries, controller, &Entry::controller);
+    if (playing != m_entries.end())
+    {
+        *playing = { controller, animation, now, now };
+    }
+    else
+    {
+        m_entries.push_back({ controller, animation, now, now });
+    }
+
+    if (!m_ticking)
+    {
+        m_ticking = true;
+        m_scheduler.submit(m_strand, [this]() { tick(); });
+    }
+}
+
+bool AnimationPlayer::stop(LEDController* controller)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::erase_if(m_entries, [controller](const Entry& entry) { return entry.controller == controller; }) > 0;
+}
+
+void AnimationPlayer::tick()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const clock::time_point now = clock::now();
+
+    // Frames that are due go into one batch. The dither residue lives with each entry, an entry that
+    // does not dither starts from zero every frame, which encodes exactly like plain rounding.
+    m_batched.clear();
+    m_batch.resize(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        Entry& entry = m_entries[i];
+        if (now < entry.next_frame)
+        {
+            continue;
+        }
+        LEDController* controller = entry.controller;
+        const std::chrono::duration<float> interval(1.0f / std::max(controller->m_max_command_rate.load(), LEDController::MIN_COMMAND_RATE));
+        entry.next_frame = std::max(entry.next_frame + std::chrono::duration_cast<clock::duration>(interval), now);
+        entry.elapsed_s = std::chrono::duration<float>(now - entry.started).count();
+        if (!controller->is_connected())
+        {
+            continue;
+        }
+
+        // The configured brightness stays the master dimmer
+        const DeviceState& state = controller->m_animation_channel.read();
+        const std::array<float, 3> color = entry.animation->sample(entry.elapsed_s);
+        if (!controller->m_dithering_enabled || controller->m_max_command_rate < LEDController::DITHER_MIN_RATE)
+        {
+            entry.dither_error = {};
+        }
+        m_batch.set(m_batched.size(), color, state.brightness, state.curve);
+        m_batch.set_error(m_batched.size(), entry.dither_error);
+        m_batched.push_back(i);
+    }
+
+    m_batch.resize(m_batched.size());
+    m_batch.encode_dithered(m_payloads);
+    for (size_t i = 0; i < m_batched.size(); i++)
+    {
+        Entry& entry = m_entries[m_batched[i]];
+        entry.dither_error = m_batch.error(i);
+        const ColorPayload& payload = m_payloads[i];
+        entry.controller->write_command(CommandType::COLOR, SimpleBLE::ByteArray(payload.begin(), payload.end()));
+    }
+
+    // Finished animations hold their last color
+    std::erase_if(m_entries, [](const Entry& entry) { return entry.animation->is_finished(entry.elapsed_s); });
+    if (m_entries.empty())
+    {
+        m_ticking = false;
+        return;
+    }
+    m_scheduler.submit_after(m_strand, TICK_INTERVAL, [this]() { tick(); });
+}
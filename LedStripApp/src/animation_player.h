@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+#include "ble_scheduler.h"
+#include "color_pipeline.h"
+#include "animation.h"
+
+class LEDController;
+
+// Plays the host side animations of all controllers. Every tick samples the frames that are due,
+// encodes them in one ColorBatch and queues them to their controllers, each controller still gets
+// frames at its own max command rate. The tick runs as a job on its own strand of the scheduler.
+class AnimationPlayer
+{
+public:
+	explicit AnimationPlayer(BLEScheduler& scheduler);
+	~AnimationPlayer();
+
+	void play(LEDController* controller, std::shared_ptr<const Animation> animation);
+	// No frame of the controller is queued once this returns, false if it was not playing
+	bool stop(LEDController* controller);
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	struct Entry
+	{
+		LEDController* controller;
+		std::shared_ptr<const Animation> animation;
+		clock::time_point started;
+		clock::time_point next_frame;
+		float elapsed_s = 0.0f; // When the last frame was due
+		DitherError dither_error = {};
+	};
+
+	static constexpr std::chrono::microseconds TICK_INTERVAL{ 16667 }; // The highest max command rate, 60 Hz
+
+	void tick();
+
+	BLEScheduler& m_scheduler;
+	std::shared_ptr<BLEScheduler::Strand> m_strand;
+
+	std::mutex m_mutex; // Held for a whole tick
+	std::vector<Entry> m_entries;
+	bool m_ticking = false;
+
+	// Reused by every tick, only touched with m_mutex held
+	ColorBatch m_batch;
+	std::vector<size_t> m_batched; // Entry of each batch index
+	std::vector<ColorPayload> m_payloads;
+};
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <filesystem>
 #include <ranges>
+#include <algorithm>
+#include <chrono>
 #include "app.h"
 #include "helpers.h"
 #include "yaml-cpp/yaml.h"
@@ -18,36 +20,59 @@ App::App() : m_window(L"LED Strip Controller"), m_timer(this)
     m_led_controllers.emplace_back(std::make_unique<LEDController>(this, name, true));
     m_selected_controller = 0;
 
-    m_led_configs.emplace_back(std::make_unique<LEDConfiguration>(name, false, std::array<float, 3>{1.0f, 1.0f, 1.0f}, 1.0f, Mode(0, 0.0f)));
-    m_selected_led_configs = { { name, 0 } };
-
-    m_timer_configs.emplace_back(std::make_unique<TimerConfiguration>(name, 0.0f, 1.0f, 1, false));
-    m_selected_timer_configs = { { name, 0 } };
+    m_led_configs.insert(std::make_unique<LEDConfiguration>(name, false, std::array<float, 3>{1.0f, 1.0f, 1.0f}, 1.0f, Mode(0, 0.0f)));
+    m_timer_configs.insert(std::make_unique<TimerConfiguration>(name, 0.0f, 1.0f, 1, false));
 }
 
 App::~App() {
-    save_settings();
+    m_timer.shutdown(); // No timer edges may fire into controllers being destroyed
+    flush_journal(); // Edits are durable once journaled, exit does not wait for a full snapshot
+    m_journal.flush();
+    m_settings_writer.wait(); // Unless one is being written right now
     for (size_t i = 1; i < m_led_controllers.size(); i++)
     {
         if (m_led_controllers[i]->is_device_on()) m_led_controllers[i]->toggle_device();
     }
-    m_led_controllers.clear(); // Call destructor of controllers to joint threads
+    m_led_controllers.clear(); // Call destructor of controllers to flush their pending writes
     ImGui_ImplDX12_Shutdown();
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyContext();
     ImPlot::DestroyContext();
 }
 
-bool App::init()
+bool App::init(std::wstring_view command_line)
 {
 	if (!m_window.init())
 	{
 		return false;
 	}
+    parse_command_line(command_line);
     load_settings();
 	return true;
 }
 
+void App::parse_command_line(std::wstring_view command_line)
+{
+    // --simulate=<options> sets how devices named SIM-... behave, see SimulationProfile::parse
+    constexpr std::wstring_view SIMULATE_OPTION = L"--simulate=";
+    const size_t start = command_line.find(SIMULATE_OPTION);
+    if (start == std::wstring_view::npos)
+    {
+        return;
+    }
+    std::wstring_view value = command_line.substr(start + SIMULATE_OPTION.size());
+    value = value.substr(0, value.find(L' '));
+    std::string options;
+    std::ranges::transform(value, std::back_inserter(options), [](wchar_t c) { return static_cast<char>(c); });
+
+    if (std::optional<SimulationProfile> profile = SimulationProfile::parse(options))
+    {
+        m_discovery.set_simulation_profile(*profile);
+        std::cout << "[Info] Simulating devices with loss rate " << profile->loss_rate << ", disconnect rate " << profile->disconnect_rate
+            << " and seed " << profile->seed << "." << std::endl;
+    }
+}
+
 void App::run()
 {
     // Setup Dear ImGui context
@@ -114,9 +139,10 @@ void App::run()
 
     while (m_window.isOpen())
     {
-        led_controller()->try_join_scanning_thread();
+        m_timer.update();
         render();
         m_window.render();
+        flush_journal();
     }
 
     m_window.waitForLastSubmittedFrame();
@@ -198,220 +224,215 @@ void App::load_settings()
         return;
     }
 
-    // Construct the settings.yaml file path
-    std::wstring settings_file = path + L"\\settings.yaml";
+    if (!std::filesystem::exists(path))
+    {
+        std::filesystem::create_directory(path);
+    }
+    m_settings_directory = path;
+    m_settings_writer.open(m_settings_directory);
 
-    // Open the YAML file
+    const auto load_start = std::chrono::steady_clock::now();
     try
     {
-        // Construct the settings.yaml file path
-        std::ifstream file(settings_file);
-        if (!file.is_open())
-        {
-            save_settings();  // If file doesn't exist, save current settings
-            return;
-        }
-
-        YAML::Node settings = YAML::Load(file);  // Load YAML from file
-
-        // Load LED controllers
-        if (settings["controllers"])
-        {
-            m_led_controllers.resize(1 + settings["controllers"].size());
-            for (size_t i = 1; i < m_led_controllers.size(); i++)
-            {
-                // Predefine parameters needed to load LED controller
-                std::string name = "\0";
-                int selected_led_config = 0;
-                int selected_timer_config = 0;
-                bool timer_enabled = true;
-
-                // Load values
-                const YAML::Node& controller_yaml = settings["controllers"][i];
-                if (controller_yaml["name"])
-                    name = controller_yaml["name"].as<std::string>();
-
-                if (controller_yaml["selected_led_config"])
-                    selected_led_config = controller_yaml["selected_led_config"].as<int>();
-
-                if (controller_yaml["selected_timer_config"])
-                    selected_timer_config = controller_yaml["selected_timer_config"].as<int>();
-
-                if (controller_yaml["timer_enabled"])
-                    timer_enabled = controller_yaml["timer_enabled"].as<bool>();
-
-                // Create controller
-                m_led_controllers[i] = std::make_unique<LEDController>(this, name, timer_enabled);
-                m_selected_led_configs[name] = selected_led_config;
-                m_selected_timer_configs[name] = selected_timer_config;
-            }
-        }
+        // Without settings files, edits made before the first snapshot was saved are in journal 0
+        SettingsSnapshot snapshot = load_snapshot(m_settings_directory).value_or(SettingsSnapshot{});
 
-        // Load LED configurations
-        if (settings["led_configs"])
+        // Edits made after the snapshot was written
+        const size_t replayed = SettingsJournal::replay(m_settings_directory, snapshot.journal_epoch, snapshot, m_journal_epoch);
+        if (replayed > 0)
         {
-            m_led_configs.resize(1 + settings["led_configs"].size());
-            for (size_t i = 1; i < m_led_configs.size(); i++)
-            {
-                // Predefine parameters needed to load LED configuration
-                std::string name = "\0";
-                bool device_on = false;
-                std::array<float, 3> color = { 1.0f, 1.0f, 1.0f };
-                float brightness = 1.0f;
-                Mode mode = { 0, 0.0f };
-
-                // Load values
-                const YAML::Node& led_config_yaml = settings["led_configs"][i];
-                if (led_config_yaml["name"])
-                    name = led_config_yaml["name"].as<std::string>();
-
-                if (led_config_yaml["device_on"])
-                    device_on = led_config_yaml["device_on"].as<bool>();
-
-                if (led_config_yaml["color"])
-                {
-                    const YAML::Node& color_yaml = led_config_yaml["color"];
-                    if (color_yaml.size() == 3)
-                    {
-                        color[0] = color_yaml[0].as<float>();
-                        color[1] = color_yaml[1].as<float>();
-                        color[2] = color_yaml[2].as<float>();
-                    }
-                }
-
-                if (led_config_yaml["brightness"])
-                    brightness = led_config_yaml["brightness"].as<float>();
-
-                if (led_config_yaml["mode"])
-                {
-                    const YAML::Node& mode_yaml = led_config_yaml["mode"];
-                    if (mode_yaml["index"])
-                        mode.index = mode_yaml["index"].as<int>();
-                    if (mode_yaml["speed"])
-                        mode.speed = mode_yaml["speed"].as<float>();
-                }
-
-                // Load led configuration
-                m_led_configs[i] = std::make_unique<LEDConfiguration>(name, device_on, color, brightness, mode);
-            }
+            std::cout << "[Info] Replayed " << replayed << " settings changes from the journal." << std::endl;
         }
 
-        if (settings["timer_configs"])
-        {
-            m_timer_configs.resize(1 + settings["timer_configs"].size());
-            for (size_t i = 1; i < m_timer_configs.size(); i++)
-            {
-                // Predefine parameters needed to load timer configuration
-                std::string name = "\0";
-                float start = 0.0f;
-                float end = 10.0f;
-                int repeat = 1;
-                bool inverse = false;
-
-                // Load values
-                const YAML::Node& timer_config_yaml = settings["timer_configs"][i];
-                if (timer_config_yaml["name"])
-                    name = timer_config_yaml["name"].as<std::string>();
+        apply_snapshot(snapshot);
+        m_timer.reschedule();
+        m_journal.open(m_settings_directory, snapshot.journal_epoch);
+        compact_settings(); // Folds the replayed changes into the snapshot
 
-                if (timer_config_yaml["start"])
-                    start = timer_config_yaml["start"].as<float>();
-
-                if (timer_config_yaml["end"])
-                    end = timer_config_yaml["end"].as<float>();
-
-                if (timer_config_yaml["repeat"])
-                    repeat = timer_config_yaml["repeat"].as<int>();
-
-                if (timer_config_yaml["inverse"])
-                    inverse = timer_config_yaml["inverse"].as<bool>();
-
-                // Load timer configuration
-                m_timer_configs[i] = std::make_unique<TimerConfiguration>(name, start, end, repeat, inverse);
-            }
-        }
-
-        file.close();
-        std::cout << "[Info] Loaded settings." << std::endl;
+        const std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+        std::cout << "[Info] Loaded settings in " << load_time.count() << " ms." << std::endl;
     }
     catch (const YAML::Exception& ex)
     {
         // Handle YAML exceptions (e.g., file errors, parsing errors)
         std::cout << "[Error] Failed to load settings: " << ex.what() << std::endl;
+        m_journal.open(m_settings_directory, m_journal_epoch);
+        compact_settings();
     }
 }
 
+void App::apply_snapshot(const SettingsSnapshot& snapshot)
+{
+    // Load LED configurations
+    for (const LEDConfiguration& config : snapshot.led_configs)
+    {
+        m_led_configs.insert(std::make_unique<LEDConfiguration>(config));
+    }
+
+    // Load timer configurations
+    for (const TimerSettings& settings : snapshot.timer_configs)
+    {
+        std::unique_ptr<TimerConfiguration> config = std::make_unique<TimerConfiguration>(settings.name, settings.start, settings.end, settings.repeat, settings.inverse);
+        config->anchor = settings.anchor;
+        config->wall_clock = settings.wall_clock;
+        m_timer_configs.insert(std::move(config));
+    }
+
+    // Load LED controllers, the files refer to configurations by position
+    m_led_controllers.resize(1 + snapshot.controllers.size());
+    for (size_t i = 1; i < m_led_controllers.size(); i++)
+    {
+        const ControllerSettings& settings = snapshot.controllers[i - 1];
+        m_led_controllers[i] = std::make_unique<LEDController>(this, settings.name, settings.timer_enabled);
+        m_led_controllers[i]->m_streaming_enabled = settings.streaming_enabled;
+        m_led_controllers[i]->m_max_command_rate = settings.max_command_rate;
+        m_led_controllers[i]->m_dithering_enabled = settings.dithering_enabled;
+        if (settings.selected_led_config > 0 && static_cast<size_t>(settings.selected_led_config) < m_led_configs.size())
+            m_led_controllers[i]->m_led_config = m_led_configs.handle(settings.selected_led_config);
+        if (settings.selected_timer_config > 0 && static_cast<size_t>(settings.selected_timer_config) < m_timer_configs.size())
+            m_led_controllers[i]->m_timer_config = m_timer_configs.handle(settings.selected_timer_config);
+    }
+
+    m_groups = snapshot.groups;
+}
+
 void App::save_settings()
 {
-    std::wstring path = fetch_settings_path();
-    if (std::empty(path))
+    if (m_settings_directory.empty())
     {
         return;
     }
+    m_settings_writer.write(take_snapshot()); // Serialized and written on the writer's thread
+}
 
-    if (!std::filesystem::exists(path))
+ControllerSettings App::controller_settings(size_t index)
+{
+    const LEDController& controller = *m_led_controllers[index];
+    return {
+        controller.m_name,
+        static_cast<int>(m_led_configs.position(controller.m_led_config).value_or(0)),
+        static_cast<int>(m_timer_configs.position(controller.m_timer_config).value_or(0)),
+        controller.m_timer_enabled,
+        controller.m_streaming_enabled.load(),
+        controller.m_max_command_rate.load(),
+        controller.m_dithering_enabled.load()
+    };
+}
+
+TimerSettings App::timer_settings(size_t index)
+{
+    const TimerConfiguration& config = m_timer_configs[index];
+    return { config.name, config.start, config.end, config.repeat, config.inverse, config.anchor, config.wall_clock };
+}
+
+SettingsSnapshot App::take_snapshot()
+{
+    SettingsSnapshot snapshot;
+    for (size_t i = 1; i < m_led_controllers.size(); i++)
     {
-        std::filesystem::create_directory(path);
+        snapshot.controllers.push_back(controller_settings(i));
+    }
+    for (size_t i = 1; i < m_led_configs.size(); i++)
+    {
+        snapshot.led_configs.push_back(m_led_configs[i]);
+    }
+    for (size_t i = 1; i < m_timer_configs.size(); i++)
+    {
+        snapshot.timer_configs.push_back(timer_settings(i));
     }
+    snapshot.groups = m_groups;
+    snapshot.journal_epoch = m_journal_epoch;
+    return snapshot;
+}
 
-    // Construct the settings.yaml file path
-    std::wstring settings_file = path + L"\\settings.yaml";
+void App::mark_controller_changed(const LEDController* controller)
+{
+    m_changed_controllers.insert(controller);
+}
 
-    try
+void App::mark_led_config_changed(const LEDConfiguration* config)
+{
+    m_changed_led_configs.insert(config);
+}
+
+void App::mark_timer_config_changed(TimerConfiguration* config)
+{
+    config->mark_changed();
+    m_changed_timer_configs.insert(config);
+}
+
+void App::flush_journal()
+{
+    if (m_settings_directory.empty())
+    {
+        return; // Nowhere to save to
+    }
+    if (m_journal.switching_epoch() && m_settings_writer.durable_epoch() >= m_journal_epoch)
+    {
+        m_journal.end_epoch(); // The new snapshot is on disk, the older journal is no longer needed
+    }
+    if (!m_journal.switching_epoch() && m_journal.record_count() >= JOURNAL_COMPACT_THRESHOLD)
     {
-        // Create a YAML node and populate it with settings
-        YAML::Node settings;
+        compact_settings(); // The journal grew long, start over from a fresh snapshot
+        return;
+    }
 
-        for (size_t i = 1; i < m_led_controllers.size(); i++)
-        {
-            settings["controllers"][i]["name"] = m_led_controllers[i]->m_name;
-            settings["controllers"][i]["selected_led_config"] = m_selected_led_configs[m_led_controllers[i]->m_name];
-            settings["controllers"][i]["selected_timer_config"] = m_selected_timer_configs[m_led_controllers[i]->m_name];
-            settings["controllers"][i]["timer_enabled"] = m_led_controllers[i]->m_timer_enabled;
-        }
-        
-        for (size_t i = 1; i < m_led_configs.size(); i++)
+    // Entries that are not in the snapshot (index 0 is the default) are never journaled
+    for (size_t i = 1; i < m_led_controllers.size() && !m_changed_controllers.empty(); i++)
+    {
+        if (m_changed_controllers.erase(m_led_controllers[i].get()))
         {
-            settings["led_configs"][i]["name"] = m_led_configs[i]->name;
-            settings["led_configs"][i]["device_on"] = m_led_configs[i]->device_on;
-            settings["led_configs"][i]["color"] = YAML::Node(YAML::NodeType::Sequence); // List for color values
-            settings["led_configs"][i]["color"].push_back(m_led_configs[i]->color[0]);
-            settings["led_configs"][i]["color"].push_back(m_led_configs[i]->color[1]);
-            settings["led_configs"][i]["color"].push_back(m_led_configs[i]->color[2]);
-            settings["led_configs"][i]["brightness"] = m_led_configs[i]->brightness;
-            settings["led_configs"][i]["mode"]["index"] = m_led_configs[i]->mode.index;
-            settings["led_configs"][i]["mode"]["speed"] = m_led_configs[i]->mode.speed;
+            m_journal.append("controllers", static_cast<int>(i), settings_yaml::flow(controller_settings(i)));
         }
-
-        for (size_t i = 1; i < m_timer_configs.size(); i++)
+    }
+    for (size_t i = 1; i < m_led_configs.size() && !m_changed_led_configs.empty(); i++)
+    {
+        if (m_changed_led_configs.erase(&m_led_configs[i]))
         {
-            settings["timer_configs"][i]["name"] = m_timer_configs[i]->name;
-            settings["timer_configs"][i]["start"] = m_timer_configs[i]->start;
-            settings["timer_configs"][i]["end"] = m_timer_configs[i]->end;
-            settings["timer_configs"][i]["repeat"] = m_timer_configs[i]->repeat;
-            settings["timer_configs"][i]["inverse"] = m_timer_configs[i]->inverse;
+            m_journal.append("led_configs", static_cast<int>(i), settings_yaml::flow(m_led_configs[i]));
         }
-
-        // Save the YAML node to the file
-        std::ofstream file(settings_file);
-        if (!file.is_open())
+    }
+    for (size_t i = 1; i < m_timer_configs.size() && !m_changed_timer_configs.empty(); i++)
+    {
+        if (m_changed_timer_configs.erase(&m_timer_configs[i]))
         {
-            return;
+            m_journal.append("timer_configs", static_cast<int>(i), settings_yaml::flow(timer_settings(i)));
         }
-        file << settings; // Write YAML to the file
-        std::cout << "[Info] Saved settings." << std::endl;
     }
-    catch (const YAML::Exception& ex)
+    if (m_groups_changed)
+    {
+        m_groups_changed = false;
+        m_journal.append("groups", -1, settings_yaml::flow(m_groups));
+    }
+    m_changed_controllers.clear();
+    m_changed_led_configs.clear();
+    m_changed_timer_configs.clear();
+}
+
+void App::compact_settings()
+{
+    if (m_settings_directory.empty())
     {
-        // Handle YAML exceptions (e.g., serialization errors)
-        std::cout << "[Error] Failed to save settings: " << ex.what() << std::endl;
+        return;
     }
+
+    // The snapshot holds everything before the next epoch. Until it is on disk, later edits are
+    // journaled for both epochs, the older snapshot stays complete if this one never lands.
+    m_journal_epoch++;
+    m_journal.begin_epoch(m_journal_epoch);
+    save_settings();
+    m_changed_controllers.clear();
+    m_changed_led_configs.clear();
+    m_changed_timer_configs.clear();
+    m_groups_changed = false;
 }
 
 bool App::create_new_controller(std::string name)
 {
     m_led_controllers.emplace_back(std::make_unique<LEDController>(this, name, true));
-    m_selected_led_configs[name] = 0;
-    m_selected_timer_configs[name] = 0;
+    m_timer.reschedule();
+    const size_t index = m_led_controllers.size() - 1;
+    m_journal.append("controllers", static_cast<int>(index), settings_yaml::flow(controller_settings(index)));
     return true;
 }
 
@@ -455,9 +476,16 @@ bool App::delete_selected_controller()
         {
             m_led_controllers[*index]->toggle_device();
         }
-        m_selected_led_configs.erase(m_led_controllers[*index]->m_name);
+        for (ControllerGroup& group : m_groups)
+        {
+            std::erase(group.members, m_led_controllers[*index]->m_name);
+        }
+        std::unique_ptr<LEDController> controller = std::move(m_led_controllers[*index]);
         m_led_controllers.erase(m_led_controllers.begin() + *index);
         m_selected_controller = 0;
+        m_timer.reschedule(); // Before the controller is destroyed, the timer may still reference it
+        m_journal.erase("controllers", *index);
+        m_groups_changed = true;
     }
     catch (std::out_of_range& err)
     {
@@ -466,10 +494,83 @@ bool App::delete_selected_controller()
     }
 }
 
+bool App::create_new_group(std::string name)
+{
+    m_groups.push_back({ name, {} });
+    m_groups_changed = true;
+    return true;
+}
+
+bool App::delete_group(int index)
+{
+    if (index < 0 || index >= static_cast<int>(m_groups.size()))
+    {
+        std::cout << "[Error] Failed to delete group: index out of range." << std::endl;
+        return false;
+    }
+    m_groups.erase(m_groups.begin() + index);
+    m_groups_changed = true;
+    return true;
+}
+
+bool App::toggle_group_member(int index)
+{
+    if (index < 0 || index >= static_cast<int>(m_groups.size()))
+    {
+        std::cout << "[Error] Failed to update group: index out of range." << std::endl;
+        return false;
+    }
+    if (m_selected_controller == 0)
+    {
+        return false; // Default controller, not a device
+    }
+    std::vector<std::string>& members = m_groups[index].members;
+    if (std::erase(members, led_controller()->m_name) == 0)
+    {
+        members.push_back(led_controller()->m_name);
+    }
+    m_groups_changed = true;
+    return true;
+}
+
+bool App::apply_led_config_to_group(int index)
+{
+    if (index < 0 || index >= static_cast<int>(m_groups.size()))
+    {
+        std::cout << "[Error] Failed to update group: index out of range." << std::endl;
+        return false;
+    }
+
+    // The selected controller's configuration becomes the scene of every member
+    const LEDConfigHandle led_config = led_controller()->m_led_config;
+    std::vector<LEDController*> members;
+    for (const std::unique_ptr<LEDController>& controller : m_led_controllers | std::views::drop(1))
+    {
+        if (!helpers::exists_in_vector(m_groups[index].members, controller->m_name))
+        {
+            continue;
+        }
+        if (controller->animation())
+        {
+            controller->stop_animation();
+        }
+        controller->m_led_config = led_config;
+        mark_controller_changed(controller.get());
+        members.push_back(controller.get());
+    }
+
+    std::cout << "[Info] Applying led config to " << members.size() << " controllers of group \'" << m_groups[index].name << "\'." << std::endl;
+    m_last_fan_out = LEDController::fan_out(m_groups[index].name, members);
+    return true;
+}
+
 bool App::create_new_led_config(std::string name)
 {
-    m_led_configs.emplace_back(std::make_unique<LEDConfiguration>(*led_controller()->led_config()));
-    m_led_configs.back()->name = name;
+    std::unique_ptr<LEDConfiguration> config = std::make_unique<LEDConfiguration>(*led_controller()->led_config());
+    config->name = name;
+    m_led_configs.insert(std::move(config));
+    const size_t position = m_led_configs.size() - 1;
+    m_journal.append("led_configs", static_cast<int>(position), settings_yaml::flow(m_led_configs[position]));
     return true;
 }
 
@@ -477,7 +578,8 @@ bool App::update_controller_led_config(int index)
 {
     try
     {
-        m_selected_led_configs.at(led_controller()->m_name) = index;
+        led_controller()->m_led_config = m_led_configs.handle(index);
+        mark_controller_changed(led_controller());
         led_controller()->update_all();
     }
     catch (std::out_of_range& err)
@@ -490,6 +592,7 @@ bool App::update_controller_led_config(int index)
 bool App::rename_selected_led_config(std::string new_name)
 {
     led_controller()->led_config()->name = new_name;
+    mark_led_config_changed(led_controller()->led_config());
     return true;
 }
 
@@ -497,28 +600,16 @@ bool App::delete_selected_led_config()
 {
     try
     {
-        std::optional<int> index = helpers::index_in_vector(led_config_names(), led_controller()->led_config()->name);
-
-        if (!index)
+        const LEDConfigHandle handle = led_controller()->m_led_config;
+        if (!m_led_configs.get(handle) || handle == m_led_configs.handle(0))
         {
             throw std::runtime_error("Led config not found.");
         }
 
-        *index += 1; // To account for default config
-        m_led_configs.erase(m_led_configs.begin() + *index);
-        for (size_t i = 0; i < m_led_controllers.size(); i++)
-        {
-            if (m_selected_led_configs[m_led_controllers[i]->m_name] == *index)
-            {
-                m_selected_led_configs[m_led_controllers[i]->m_name] = 0;
-            }
-            else if (m_selected_led_configs[m_led_controllers[i]->m_name] > *index)
-            {
-                m_selected_led_configs[m_led_controllers[i]->m_name] -= 1;
-            }
-
-        }
+        const size_t position = *m_led_configs.position(handle);
+        m_led_configs.erase(handle); // Controllers still holding it fall back to the default
         led_controller()->update_all();
+        m_journal.erase("led_configs", static_cast<int>(position));
         return true;
     }
     catch (std::runtime_error& err)
@@ -530,8 +621,12 @@ bool App::delete_selected_led_config()
 
 bool App::create_new_timer_config(std::string name)
 {
-    m_timer_configs.emplace_back(std::make_unique<TimerConfiguration>(*led_controller()->timer_config()));
-    m_timer_configs.back()->name = name;
+    std::unique_ptr<TimerConfiguration> config = std::make_unique<TimerConfiguration>(*led_controller()->timer_config());
+    config->name = name;
+    config->mark_changed(); // Copied with the version of the original, the Live Timer View keys on the newest one
+    m_timer_configs.insert(std::move(config));
+    const size_t position = m_timer_configs.size() - 1;
+    m_journal.append("timer_configs", static_cast<int>(position), settings_yaml::flow(timer_settings(position)));
     return true;
 }
 
@@ -539,7 +634,9 @@ bool App::update_controller_timer_config(int index)
 {
     try
     {
-        m_selected_timer_configs.at(led_controller()->m_name) = index;
+        led_controller()->m_timer_config = m_timer_configs.handle(index);
+        mark_controller_changed(led_controller());
+        m_timer.reschedule();
     }
     catch (std::out_of_range& err)
     {
@@ -551,6 +648,7 @@ bool App::update_controller_timer_config(int index)
 bool App::rename_selected_timer_config(std::string new_name)
 {
     led_controller()->timer_config()->name = new_name;
+    mark_timer_config_changed(led_controller()->timer_config());
     return true;
 }
 
@@ -558,27 +656,16 @@ bool App::delete_selected_timer_config()
 {
     try
     {
-        std::optional<int> index = helpers::index_in_vector(timer_config_names(), led_controller()->timer_config()->name);
-
-        if (!index)
+        const TimerConfigHandle handle = led_controller()->m_timer_config;
+        if (!m_timer_configs.get(handle) || handle == m_timer_configs.handle(0))
         {
             throw std::runtime_error("Timer config not found.");
         }
 
-        *index += 1; // To account for default config
-        m_timer_configs.erase(m_timer_configs.begin() + *index);
-        for (size_t i = 0; i < m_led_controllers.size(); i++)
-        {
-            if (m_selected_timer_configs[m_led_controllers[i]->m_name] == *index)
-            {
-                m_selected_timer_configs[m_led_controllers[i]->m_name] = 0;
-            }
-            else if (m_selected_timer_configs[m_led_controllers[i]->m_name] > *index)
-            {
-                m_selected_timer_configs[m_led_controllers[i]->m_name] -= 1;
-            }
-
-        }
+        const size_t position = *m_timer_configs.position(handle);
+        m_timer_configs.erase(handle); // Controllers still holding it fall back to the default
+        m_timer.reschedule();
+        m_journal.erase("timer_configs", static_cast<int>(position));
         return true;
     }
     catch (std::runtime_error& err)
@@ -625,8 +712,8 @@ std::vector<std::string> App::led_controller_aliases()
 std::vector<std::string> App::led_config_names()
 {
     std::vector<std::string> names;
-    std::ranges::transform(m_led_configs, std::back_inserter(names), [](std::unique_ptr<LEDConfiguration>& led_config) 
-        { return led_config->name; }
+    std::ranges::transform(m_led_configs.values(), std::back_inserter(names), [](const LEDConfiguration& led_config)
+        { return led_config.name; }
     );
     names.erase(names.begin()); // TODO: Smarter way to ignore first element
     return names;
@@ -635,8 +722,8 @@ std::vector<std::string> App::led_config_names()
 std::vector<std::string> App::timer_config_names()
 {
     std::vector<std::string> names;
-    std::ranges::transform(m_timer_configs, std::back_inserter(names), [](std::unique_ptr<TimerConfiguration>& timer_config)
-        { return timer_config->name; }
+    std::ranges::transform(m_timer_configs.values(), std::back_inserter(names), [](const TimerConfiguration& timer_config)
+        { return timer_config.name; }
     );
     names.erase(names.begin()); // TODO: Smarter way to ignore first element
     return names;
@@ -4,12 +4,23 @@
 #include <vector>
 #include <memory>
 #include <ranges>
+#include <unordered_set>
+#include <filesystem>
+#include <string_view>
 
 #include "window.h"
+#include "ble_scheduler.h"
+#include "discovery_service.h"
 #include "led_controller.h"
 #include "led_configuration.h"
+#include "controller_group.h"
+#include "slot_map.h"
+#include "settings_journal.h"
+#include "settings_snapshot.h"
 #include "timer.h"
 #include "timer_configuration.h"
+#include "animation.h"
+#include "animation_player.h"
 #include "app_tab.h"
 #include "light_tab.h"
 #include "log_tab.h"
@@ -20,16 +31,28 @@ public:
 	App();
 	~App();
 
-	bool init();
+	bool init(std::wstring_view command_line);
 	void run();
 
 private:
 	void render();
+	void parse_command_line(std::wstring_view command_line);
 
 	// Fetching settings
 	std::wstring fetch_settings_path();
 	void load_settings();
+	void apply_snapshot(const SettingsSnapshot& snapshot);
 	void save_settings();
+	ControllerSettings controller_settings(size_t index);
+	TimerSettings timer_settings(size_t index);
+	SettingsSnapshot take_snapshot();
+
+	// Settings journal, changes are marked while editing and written once per frame
+	void mark_controller_changed(const LEDController* controller);
+	void mark_led_config_changed(const LEDConfiguration* config);
+	void mark_timer_config_changed(TimerConfiguration* config); // Also bumps its version for the plot cache
+	void flush_journal();
+	void compact_settings(); // Starts a new journal epoch and saves a snapshot
 
 	// Updating
 	bool create_new_controller(std::string name);
@@ -44,6 +67,10 @@ private:
 	bool update_controller_timer_config(int index);
 	bool delete_selected_timer_config();
 	bool rename_selected_timer_config(std::string new_name);
+	bool create_new_group(std::string name);
+	bool delete_group(int index);
+	bool toggle_group_member(int index); // Adds or removes the selected controller
+	bool apply_led_config_to_group(int index); // Sends the selected controller's led config to every member
 
 	// Getters
 	LEDController* led_controller();
@@ -56,16 +83,32 @@ private:
 	Window m_window;
 
 	friend class LEDController;
+	BLEScheduler m_ble_scheduler; // Declared before the controllers so it outlives their jobs
+	DiscoveryService m_discovery;
+	AnimationPlayer m_animation_player = AnimationPlayer(m_ble_scheduler); // Outlives the controllers playing on it
 	std::vector<std::unique_ptr<LEDController>> m_led_controllers;
 	int m_selected_controller;
 
-	std::vector<std::unique_ptr<LEDConfiguration>> m_led_configs;
-	std::map<std::string, int> m_selected_led_configs;
+	SlotMap<LEDConfiguration> m_led_configs; // Position 0 is the default, controllers hold handles
 
 	friend class Timer;
 	Timer m_timer;
-	std::vector<std::unique_ptr<TimerConfiguration>> m_timer_configs;
-	std::map<std::string, int> m_selected_timer_configs;
+	SlotMap<TimerConfiguration> m_timer_configs;
+
+	std::vector<std::shared_ptr<const Animation>> m_animations = Animation::presets();
+
+	std::vector<ControllerGroup> m_groups;
+	std::shared_ptr<FanOutTracker> m_last_fan_out; // Shown in the UI until the next fan-out
+
+	static constexpr size_t JOURNAL_COMPACT_THRESHOLD = 512; // Records before the snapshot is rewritten
+	std::filesystem::path m_settings_directory;
+	SettingsWriter m_settings_writer;
+	SettingsJournal m_journal;
+	uint64_t m_journal_epoch = 0;
+	std::unordered_set<const LEDController*> m_changed_controllers;
+	std::unordered_set<const LEDConfiguration*> m_changed_led_configs;
+	std::unordered_set<const TimerConfiguration*> m_changed_timer_configs;
+	bool m_groups_changed = false;
 
     AppTab* m_current_tab = nullptr;
 
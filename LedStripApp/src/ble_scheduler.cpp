@@ -0,0 +1,310 @@
+#include <iostream>
+#include <algorithm>
+
+#include "ble_scheduler.h"
+
+BLEScheduler::BLEScheduler(size_t worker_count)
+{
+    worker_count = std::max<size_t>(worker_count, 1);
+    for (size_t i = 0; i < worker_count; i++)
+    {
+        m_queues.emplace_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < worker_count; i++)
+    {
+        m_workers.emplace_back(&BLEScheduler::worker_loop, this, i);
+    }
+}
+
+BLEScheduler::~BLEScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_idle_mutex);
+        m_stopping = true;
+    }
+    m_idle_condition.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+
+    std::vector<std::thread> blocking_workers;
+    {
+        std::lock_guard<std::mutex> lock(m_blocking_mutex);
+        m_blocking_stopping = true;
+        blocking_workers.swap(m_blocking_workers); // No more are started from here on
+    }
+    m_blocking_condition.notify_all();
+    for (std::thread& worker : blocking_workers)
+    {
+        worker.join();
+    }
+}
+
+std::shared_ptr<BLEScheduler::Strand> BLEScheduler::make_strand()
+{
+    return std::make_shared<Strand>();
+}
+
+void BLEScheduler::submit(const std::shared_ptr<Strand>& strand, Job job, Lane lane)
+{
+    {
+        std::lock_guard<std::mutex> lock(strand->mutex);
+        if (strand->closed)
+        {
+            return;
+        }
+
+        strand->jobs.push_back({ std::move(job), lane });
+        if (strand->scheduled)
+        {
+            return; // The worker owning the strand picks the job up
+        }
+        strand->scheduled = true;
+    }
+    dispatch(strand, lane, m_next_queue++ % m_queues.size());
+}
+
+void BLEScheduler::submit_after(const std::shared_ptr<Strand>& strand, clock::duration delay, Job job, Lane lane)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_idle_mutex);
+        m_timed_jobs.push_back({ clock::now() + delay, strand, std::move(job), lane });
+        std::push_heap(m_timed_jobs.begin(), m_timed_jobs.end(), [](const TimedJob& a, const TimedJob& b)
+            { return a.deadline > b.deadline; }
+        );
+    }
+    m_idle_condition.notify_one(); // Let an idle worker pick up the new deadline
+}
+
+void BLEScheduler::submit_batch(std::vector<std::pair<std::shared_ptr<Strand>, Job>> jobs)
+{
+    std::vector<std::vector<std::shared_ptr<Strand>>> ready(m_queues.size());
+    size_t ready_count = 0;
+    for (auto& [strand, job] : jobs)
+    {
+        std::lock_guard<std::mutex> lock(strand->mutex);
+        if (strand->closed)
+        {
+            continue;
+        }
+
+        strand->jobs.push_back({ std::move(job), Lane::WORKERS });
+        if (!strand->scheduled)
+        {
+            strand->scheduled = true;
+            ready[m_next_queue++ % m_queues.size()].push_back(strand);
+            ready_count++;
+        }
+    }
+    if (ready_count == 0)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < m_queues.size(); i++)
+    {
+        std::lock_guard<std::mutex> lock(m_queues[i]->mutex);
+        m_queues[i]->strands.insert(m_queues[i]->strands.end(), ready[i].begin(), ready[i].end());
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_idle_mutex);
+        m_ready_strands += static_cast<long long>(ready_count);
+    }
+    m_idle_condition.notify_all();
+}
+
+void BLEScheduler::close(const std::shared_ptr<Strand>& strand)
+{
+    std::unique_lock<std::mutex> lock(strand->mutex);
+    strand->idle_condition.wait(lock, [&strand]() { return !strand->scheduled; });
+    strand->closed = true;
+}
+
+void BLEScheduler::dispatch(std::shared_ptr<Strand> strand, Lane lane, size_t worker_index)
+{
+    if (lane == Lane::BLOCKING)
+    {
+        enqueue_blocking(std::move(strand));
+    }
+    else
+    {
+        enqueue(std::move(strand), worker_index);
+    }
+}
+
+void BLEScheduler::enqueue(std::shared_ptr<Strand> strand, size_t worker_index)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queues[worker_index]->mutex);
+        m_queues[worker_index]->strands.push_back(std::move(strand));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_idle_mutex);
+        m_ready_strands++;
+    }
+    m_idle_condition.notify_one();
+}
+
+void BLEScheduler::enqueue_blocking(std::shared_ptr<Strand> strand)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_blocking_mutex);
+        m_blocking_strands.push_back(std::move(strand));
+        if (m_blocking_strands.size() > m_idle_blocking_workers && m_blocking_workers.size() < MAX_BLOCKING_WORKERS && !m_blocking_stopping)
+        {
+            m_blocking_workers.emplace_back(&BLEScheduler::blocking_loop, this);
+        }
+    }
+    m_blocking_condition.notify_one();
+}
+
+std::shared_ptr<BLEScheduler::Strand> BLEScheduler::take(size_t worker_index)
+{
+    std::shared_ptr<Strand> strand;
+    for (size_t i = 0; i < m_queues.size() && !strand; i++)
+    {
+        // Own queue first (front), then steal from the back of the others
+        WorkerQueue& queue = *m_queues[(worker_index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.strands.empty())
+        {
+            continue;
+        }
+
+        if (i == 0)
+        {
+            strand = std::move(queue.strands.front());
+            queue.strands.pop_front();
+        }
+        else
+        {
+            strand = std::move(queue.strands.back());
+            queue.strands.pop_back();
+        }
+    }
+
+    if (strand)
+    {
+        std::lock_guard<std::mutex> lock(m_idle_mutex);
+        m_ready_strands--;
+    }
+    return strand;
+}
+
+void BLEScheduler::run(std::shared_ptr<Strand> strand, size_t worker_index)
+{
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(strand->mutex);
+        job = std::move(strand->jobs.front().first);
+        strand->jobs.pop_front();
+    }
+
+    try
+    {
+        job();
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "[Error] Unhandled exception in bluetooth job: " << e.what() << std::endl;
+    }
+
+    Lane next_lane;
+    {
+        std::lock_guard<std::mutex> lock(strand->mutex);
+        if (strand->jobs.empty())
+        {
+            strand->scheduled = false;
+            strand->idle_condition.notify_all();
+            return;
+        }
+        next_lane = strand->jobs.front().second;
+    }
+    // One job per turn keeps devices fair, the strand goes to the back of this worker's queue
+    // or to the lane of its next job
+    dispatch(std::move(strand), next_lane, worker_index);
+}
+
+void BLEScheduler::release_due_jobs()
+{
+    auto later = [](const TimedJob& a, const TimedJob& b) { return a.deadline > b.deadline; };
+
+    std::vector<TimedJob> due;
+    {
+        std::lock_guard<std::mutex> lock(m_idle_mutex);
+        const clock::time_point now = clock::now();
+        while (!m_timed_jobs.empty() && m_timed_jobs.front().deadline <= now)
+        {
+            std::pop_heap(m_timed_jobs.begin(), m_timed_jobs.end(), later);
+            due.push_back(std::move(m_timed_jobs.back()));
+            m_timed_jobs.pop_back();
+        }
+    }
+    for (TimedJob& timed_job : due)
+    {
+        submit(timed_job.strand, std::move(timed_job.job), timed_job.lane);
+    }
+}
+
+void BLEScheduler::worker_loop(size_t worker_index)
+{
+    while (true)
+    {
+        // Due timed jobs join their strands first, a pool that always has ready strands still runs them
+        release_due_jobs();
+        if (std::shared_ptr<Strand> strand = take(worker_index))
+        {
+            run(std::move(strand), worker_index);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_idle_mutex);
+        if (m_stopping && m_ready_strands <= 0)
+        {
+            return;
+        }
+        if (m_ready_strands > 0)
+        {
+            continue;
+        }
+
+        if (!m_timed_jobs.empty() && m_timed_jobs.front().deadline <= clock::now())
+        {
+            continue; // Released at the top
+        }
+
+        if (m_timed_jobs.empty())
+        {
+            m_idle_condition.wait(lock);
+        }
+        else
+        {
+            m_idle_condition.wait_until(lock, m_timed_jobs.front().deadline);
+        }
+    }
+}
+
+void BLEScheduler::blocking_loop()
+{
+    std::unique_lock<std::mutex> lock(m_blocking_mutex);
+    while (true)
+    {
+        m_idle_blocking_workers++;
+        m_blocking_condition.wait(lock, [this]() { return !m_blocking_strands.empty() || m_blocking_stopping; });
+        m_idle_blocking_workers--;
+        if (m_blocking_strands.empty())
+        {
+            return; // Stopping with nothing left to run
+        }
+
+        std::shared_ptr<Strand> strand = std::move(m_blocking_strands.front());
+        m_blocking_strands.pop_front();
+        lock.unlock();
+        run(std::move(strand), m_next_queue++ % m_queues.size());
+        lock.lock();
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <utility>
+
+// Fixed-size pool that runs all bluetooth I/O (scan, connect, write) for every controller.
+// Jobs are submitted to a strand, jobs of the same strand never run concurrently and keep their
+// submission order. Ready strands are distributed over per-worker queues and idle workers steal
+// from the back of other workers' queues. Jobs that can block for seconds, scans and connects, go
+// to a separate blocking lane instead, so they never hold up the writes of other devices. That lane
+// starts its threads on demand up to a fixed count, further blocking jobs wait for one of them.
+class BLEScheduler
+{
+public:
+	using Job = std::function<void()>;
+	using clock = std::chrono::steady_clock;
+
+	enum class Lane
+	{
+		WORKERS = 0, // Short jobs, writes
+		BLOCKING = 1 // Jobs that wait on a scan or a connect
+	};
+
+	class Strand
+	{
+	private:
+		std::mutex mutex;
+		std::condition_variable idle_condition;
+		std::deque<std::pair<Job, Lane>> jobs;
+		bool scheduled = false; // Sitting in a worker queue or running
+		bool closed = false;
+
+		friend class BLEScheduler;
+	};
+
+	explicit BLEScheduler(size_t worker_count = DEFAULT_WORKER_COUNT);
+	~BLEScheduler();
+
+	std::shared_ptr<Strand> make_strand();
+	void submit(const std::shared_ptr<Strand>& strand, Job job, Lane lane = Lane::WORKERS);
+	void submit_after(const std::shared_ptr<Strand>& strand, clock::duration delay, Job job, Lane lane = Lane::WORKERS);
+	// Submits jobs to many strands at once, the strands are spread over all workers and woken together
+	void submit_batch(std::vector<std::pair<std::shared_ptr<Strand>, Job>> jobs);
+	// Waits for all queued jobs of the strand to finish, later submissions are ignored
+	void close(const std::shared_ptr<Strand>& strand);
+
+	static constexpr size_t DEFAULT_WORKER_COUNT = 4;
+	static constexpr size_t MAX_BLOCKING_WORKERS = 4; // Concurrent scans and connects
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<std::shared_ptr<Strand>> strands;
+	};
+
+	struct TimedJob
+	{
+		clock::time_point deadline;
+		std::shared_ptr<Strand> strand;
+		Job job;
+		Lane lane;
+	};
+
+	void dispatch(std::shared_ptr<Strand> strand, Lane lane, size_t worker_index);
+	void enqueue(std::shared_ptr<Strand> strand, size_t worker_index);
+	void enqueue_blocking(std::shared_ptr<Strand> strand);
+	std::shared_ptr<Strand> take(size_t worker_index);
+	void run(std::shared_ptr<Strand> strand, size_t worker_index);
+	void release_due_jobs();
+	void worker_loop(size_t worker_index);
+	void blocking_loop();
+
+private:
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::vector<std::thread> m_workers;
+	std::atomic<size_t> m_next_queue = 0;
+
+	std::mutex m_idle_mutex;
+	std::condition_variable m_idle_condition;
+	long long m_ready_strands = 0; // Signed, a steal may be counted before the matching enqueue
+	std::vector<TimedJob> m_timed_jobs; // Min-heap on deadline, guarded by m_idle_mutex
+	bool m_stopping = false;
+
+	// Blocking lane, its threads are started on demand up to MAX_BLOCKING_WORKERS and kept for the next scan
+	std::mutex m_blocking_mutex;
+	std::condition_variable m_blocking_condition;
+	std::deque<std::shared_ptr<Strand>> m_blocking_strands;
+	std::vector<std::thread> m_blocking_workers;
+	size_t m_idle_blocking_workers = 0;
+	bool m_blocking_stopping = false;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <stdexcept>
+
+#include "simpleble/Types.h"
+
+// Thrown by transports when a connect or write fails
+class TransportError : public std::runtime_error
+{
+public:
+	explicit TransportError(const std::string& what) : std::runtime_error(what) {}
+};
+
+// Connection to a single LED controller as seen by LEDController, implemented on top of
+// SimpleBLE for real devices and in-process for simulated ones.
+class BLETransport
+{
+public:
+	virtual ~BLETransport() = default;
+
+	virtual std::string identifier() = 0;
+	virtual void connect() = 0;
+	virtual void disconnect() = 0;
+	virtual bool is_connected() = 0;
+	virtual bool can_write_command(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic) = 0;
+
+	// Acknowledged write, returns once the device confirmed it
+	virtual void write_request(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data) = 0;
+	// Write without response
+	virtual void write_command(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data) = 0;
+
+	virtual void set_callback_on_disconnected(std::function<void()> on_disconnected) = 0; // An empty function removes it
+};
@@ -0,0 +1,390 @@
+#include <algorithm>
+
+#include "color_pipeline.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define COLOR_PIPELINE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts AVX2 intrinsics anywhere, GCC and Clang only in functions targeting it
+#if defined(__GNUC__)
+#define COLOR_PIPELINE_AVX2 __attribute__((target("avx2")))
+#else
+#define COLOR_PIPELINE_AVX2
+#endif
+
+namespace
+{
+    constexpr int CURVE_BITS = 12;
+    constexpr int CURVE_SIZE = 1 << CURVE_BITS;
+    constexpr float CURVE_SCALE = static_cast<float>(CURVE_SIZE - 1);
+    constexpr size_t CURVE_COUNT = 3;
+    constexpr size_t CURVE_PADDING = 1; // AVX2 gathers 4 bytes from the last entry
+
+    // std::log/std::exp/std::pow are not constexpr before C++26
+    constexpr double LN2 = 0.693147180559945309417;
+
+    constexpr double constexpr_log(double x) // x in (0, 1]
+    {
+        int halvings = 0;
+        while (x < 0.5)
+        {
+            x *= 2.0;
+            halvings++;
+        }
+        const double z = (x - 1.0) / (x + 1.0);
+        double term = z;
+        double sum = 0.0;
+        for (int n = 1; n < 30; n += 2)
+        {
+            sum += term / n;
+            term *= z * z;
+        }
+        return 2.0 * sum - halvings * LN2;
+    }
+
+    constexpr double constexpr_exp(double y) // y <= 0
+    {
+        const int halvings = static_cast<int>(-y / LN2);
+        const double r = y + halvings * LN2;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n < 20; n++)
+        {
+            term *= r / n;
+            sum += term;
+        }
+        for (int i = 0; i < halvings; i++)
+        {
+            sum *= 0.5;
+        }
+        return sum;
+    }
+
+    constexpr double constexpr_pow(double x, double exponent)
+    {
+        return x <= 0.0 ? 0.0 : constexpr_exp(exponent * constexpr_log(x));
+    }
+
+    constexpr double cie_lstar_to_luminance(double lightness) // Both in [0, 1]
+    {
+        const double l = lightness * 100.0;
+        if (l <= 8.0)
+        {
+            return l / 903.3;
+        }
+        const double f = (l + 16.0) / 116.0;
+        return f * f * f;
+    }
+
+    // Curve output is 8.8 fixed point, the fraction is what temporal dithering carries forward
+    constexpr uint16_t to_fine(double x)
+    {
+        return static_cast<uint16_t>(x * 255.0 * 256.0 + 0.5);
+    }
+
+    constexpr int32_t round_fine(int32_t fine)
+    {
+        return (fine + 128) >> 8;
+    }
+
+    using CurveTable = std::array<uint16_t, CURVE_COUNT * CURVE_SIZE + CURVE_PADDING>;
+
+    // Output for every quantized input of every curve, baked at compile time
+    constexpr CurveTable build_curves()
+    {
+        CurveTable table{};
+        for (int i = 0; i < CURVE_SIZE; i++)
+        {
+            const double x = i / static_cast<double>(CURVE_SIZE - 1);
+            table[static_cast<size_t>(ColorCurve::LINEAR) * CURVE_SIZE + i] = to_fine(x);
+            table[static_cast<size_t>(ColorCurve::GAMMA_2_2) * CURVE_SIZE + i] = to_fine(constexpr_pow(x, 2.2));
+            table[static_cast<size_t>(ColorCurve::CIE_LSTAR) * CURVE_SIZE + i] = to_fine(cie_lstar_to_luminance(x));
+        }
+        return table;
+    }
+
+    constexpr CurveTable CURVES = build_curves();
+    static_assert(round_fine(CURVES[static_cast<size_t>(ColorCurve::GAMMA_2_2) * CURVE_SIZE + CURVE_SIZE - 1]) == 255);
+    static_assert(round_fine(CURVES[static_cast<size_t>(ColorCurve::GAMMA_2_2) * CURVE_SIZE + CURVE_SIZE / 2]) == 56); // 0.5^2.2
+    static_assert(round_fine(CURVES[static_cast<size_t>(ColorCurve::CIE_LSTAR) * CURVE_SIZE + CURVE_SIZE / 2]) == 47); // L* 50 is 18.4 % luminance
+
+    inline int32_t curve_offset(ColorCurve curve)
+    {
+        return static_cast<int32_t>(std::min(static_cast<size_t>(curve), CURVE_COUNT - 1) * CURVE_SIZE);
+    }
+
+    // Clamps to [0, 1] with NaN going to 0, the same way the vector kernels do
+    inline int32_t quantize(float value)
+    {
+        if (!(value > 0.0f))
+        {
+            value = 0.0f;
+        }
+        value = std::min(value, 1.0f);
+        return static_cast<int32_t>(value * CURVE_SCALE + 0.5f);
+    }
+
+    // Sends the nearest level and keeps the rounding residue for the next frame, so the
+    // average over a few frames lands on the fractional target
+    inline int32_t dither(int32_t fine, int32_t& error)
+    {
+        const int32_t target = fine + error;
+        const int32_t level = std::clamp(round_fine(target), 0, 255);
+        error = target - (level << 8);
+        return level;
+    }
+
+    inline void write_payload(ColorPayload& payload, int32_t red, int32_t green, int32_t blue)
+    {
+        payload = { 0x56, static_cast<uint8_t>(red), static_cast<uint8_t>(green), static_cast<uint8_t>(blue), 0x00, 0xF0, 0xAA };
+    }
+
+    // Pointers into the batch arrays, error is null when dithering is off
+    struct BatchView
+    {
+        const float* color[3];
+        const float* brightness;
+        const int32_t* offsets;
+        int32_t* error[3];
+        size_t count;
+    };
+
+    template<bool Dither>
+    void encode_scalar_view(const BatchView& view, ColorPayload* payloads)
+    {
+        for (size_t i = 0; i < view.count; i++)
+        {
+            int32_t level[3];
+            for (size_t c = 0; c < 3; c++)
+            {
+                const int32_t fine = CURVES[view.offsets[i] + quantize(view.color[c][i] * view.brightness[i])];
+                level[c] = Dither ? dither(fine, view.error[c][i]) : round_fine(fine);
+            }
+            write_payload(payloads[i], level[0], level[1], level[2]);
+        }
+    }
+
+#if defined(COLOR_PIPELINE_X86)
+    bool has_avx2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(info, 1);
+        const bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        return os_saves_ymm && (info[1] & (1 << 5));
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    const bool HAS_AVX2 = has_avx2();
+
+    inline __m128i quantize_sse(const float* color, const float* brightness)
+    {
+        __m128 value = _mm_mul_ps(_mm_loadu_ps(color), _mm_loadu_ps(brightness));
+        value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f)); // max first so NaN becomes 0
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(CURVE_SCALE)), _mm_set1_ps(0.5f)));
+    }
+
+    // SSE2 has no 32 bit min/max, saturating packs do the [0, 255] clamp instead
+    inline __m128i dither_sse(__m128i fine, int32_t* error)
+    {
+        const __m128i target = _mm_add_epi32(fine, _mm_loadu_si128(reinterpret_cast<const __m128i*>(error)));
+        __m128i level = _mm_srai_epi32(_mm_add_epi32(target, _mm_set1_epi32(128)), 8);
+        level = _mm_packs_epi32(level, level);
+        level = _mm_packus_epi16(level, level);
+        level = _mm_unpacklo_epi16(_mm_unpacklo_epi8(level, _mm_setzero_si128()), _mm_setzero_si128());
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(error), _mm_sub_epi32(target, _mm_slli_epi32(level, 8)));
+        return level;
+    }
+
+    template<bool Dither>
+    void encode_sse(const BatchView& view, ColorPayload* payloads)
+    {
+        alignas(16) int32_t index[4];
+        alignas(16) int32_t level[3][4];
+        for (size_t i = 0; i < view.count; i += 4)
+        {
+            const __m128i offset = _mm_loadu_si128(reinterpret_cast<const __m128i*>(view.offsets + i));
+            for (size_t c = 0; c < 3; c++)
+            {
+                // SSE has no gather, the table lookup stays scalar
+                _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_add_epi32(quantize_sse(view.color[c] + i, view.brightness + i), offset));
+                const __m128i fine = _mm_setr_epi32(CURVES[index[0]], CURVES[index[1]], CURVES[index[2]], CURVES[index[3]]);
+                const __m128i rounded = Dither ? dither_sse(fine, view.error[c] + i)
+                    : _mm_srai_epi32(_mm_add_epi32(fine, _mm_set1_epi32(128)), 8);
+                _mm_store_si128(reinterpret_cast<__m128i*>(level[c]), rounded);
+            }
+            for (size_t lane = 0; lane < 4 && i + lane < view.count; lane++)
+            {
+                write_payload(payloads[i + lane], level[0][lane], level[1][lane], level[2][lane]);
+            }
+        }
+    }
+
+    COLOR_PIPELINE_AVX2 inline __m256i lookup_avx2(const float* color, const float* brightness, __m256i offset)
+    {
+        __m256 value = _mm256_mul_ps(_mm256_loadu_ps(color), _mm256_loadu_ps(brightness));
+        value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+        const __m256i index = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(CURVE_SCALE)), _mm256_set1_ps(0.5f)));
+        const __m256i gathered = _mm256_i32gather_epi32(reinterpret_cast<const int*>(CURVES.data()), _mm256_add_epi32(index, offset), 2);
+        return _mm256_and_si256(gathered, _mm256_set1_epi32(0xFFFF)); // Keep the addressed entry of the 4 bytes read
+    }
+
+    COLOR_PIPELINE_AVX2 inline __m256i dither_avx2(__m256i fine, int32_t* error)
+    {
+        const __m256i target = _mm256_add_epi32(fine, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(error)));
+        __m256i level = _mm256_srai_epi32(_mm256_add_epi32(target, _mm256_set1_epi32(128)), 8);
+        level = _mm256_min_epi32(_mm256_max_epi32(level, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(error), _mm256_sub_epi32(target, _mm256_slli_epi32(level, 8)));
+        return level;
+    }
+
+    template<bool Dither>
+    COLOR_PIPELINE_AVX2 void encode_avx2(const BatchView& view, ColorPayload* payloads)
+    {
+        alignas(32) int32_t level[3][8];
+        for (size_t i = 0; i < view.count; i += 8)
+        {
+            const __m256i offset = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(view.offsets + i));
+            for (size_t c = 0; c < 3; c++)
+            {
+                const __m256i fine = lookup_avx2(view.color[c] + i, view.brightness + i, offset);
+                const __m256i rounded = Dither ? dither_avx2(fine, view.error[c] + i)
+                    : _mm256_srai_epi32(_mm256_add_epi32(fine, _mm256_set1_epi32(128)), 8);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(level[c]), rounded);
+            }
+            for (size_t lane = 0; lane < 8 && i + lane < view.count; lane++)
+            {
+                write_payload(payloads[i + lane], level[0][lane], level[1][lane], level[2][lane]);
+            }
+        }
+    }
+#endif
+}
+
+namespace color_pipeline
+{
+    ColorPayload encode(const std::array<float, 3>& color, float brightness, ColorCurve curve)
+    {
+        const int32_t offset = curve_offset(curve);
+        ColorPayload payload;
+        write_payload(payload,
+            round_fine(CURVES[offset + quantize(color[0] * brightness)]),
+            round_fine(CURVES[offset + quantize(color[1] * brightness)]),
+            round_fine(CURVES[offset + quantize(color[2] * brightness)]));
+        return payload;
+    }
+
+    ColorPayload encode_dithered(const std::array<float, 3>& color, float brightness, ColorCurve curve, DitherError& error)
+    {
+        const int32_t offset = curve_offset(curve);
+        ColorPayload payload;
+        write_payload(payload,
+            dither(CURVES[offset + quantize(color[0] * brightness)], error[0]),
+            dither(CURVES[offset + quantize(color[1] * brightness)], error[1]),
+            dither(CURVES[offset + quantize(color[2] * brightness)], error[2]));
+        return payload;
+    }
+}
+
+void ColorBatch::resize(size_t count)
+{
+    m_count = count;
+    const size_t padded = (count + LANES - 1) / LANES * LANES;
+    m_red.resize(padded, 0.0f);
+    m_green.resize(padded, 0.0f);
+    m_blue.resize(padded, 0.0f);
+    m_brightness.resize(padded, 0.0f);
+    m_curve_offset.resize(padded, 0);
+    for (std::vector<int32_t>& error : m_error)
+    {
+        error.resize(padded, 0);
+    }
+}
+
+void ColorBatch::set(size_t index, const std::array<float, 3>& color, float brightness, ColorCurve curve)
+{
+    m_red[index] = color[0];
+    m_green[index] = color[1];
+    m_blue[index] = color[2];
+    m_brightness[index] = brightness;
+    m_curve_offset[index] = curve_offset(curve);
+}
+
+void ColorBatch::reset_dither()
+{
+    for (std::vector<int32_t>& error : m_error)
+    {
+        std::ranges::fill(error, 0);
+    }
+}
+
+void ColorBatch::set_error(size_t index, const DitherError& error)
+{
+    for (size_t c = 0; c < 3; c++)
+    {
+        m_error[c][index] = error[c];
+    }
+}
+
+DitherError ColorBatch::error(size_t index) const
+{
+    return { m_error[0][index], m_error[1][index], m_error[2][index] };
+}
+
+void ColorBatch::encode(std::vector<ColorPayload>& payloads) const
+{
+    encode_batch(payloads, nullptr, false);
+}
+
+void ColorBatch::encode_scalar(std::vector<ColorPayload>& payloads) const
+{
+    encode_batch(payloads, nullptr, true);
+}
+
+void ColorBatch::encode_dithered(std::vector<ColorPayload>& payloads)
+{
+    int32_t* error[3] = { m_error[0].data(), m_error[1].data(), m_error[2].data() };
+    encode_batch(payloads, error, false);
+}
+
+void ColorBatch::encode_dithered_scalar(std::vector<ColorPayload>& payloads)
+{
+    int32_t* error[3] = { m_error[0].data(), m_error[1].data(), m_error[2].data() };
+    encode_batch(payloads, error, true);
+}
+
+void ColorBatch::encode_batch(std::vector<ColorPayload>& payloads, int32_t* const* error, bool force_scalar) const
+{
+    payloads.resize(m_count);
+    const BatchView view = {
+        { m_red.data(), m_green.data(), m_blue.data() }, m_brightness.data(), m_curve_offset.data(),
+        { error ? error[0] : nullptr, error ? error[1] : nullptr, error ? error[2] : nullptr }, m_count };
+#if defined(COLOR_PIPELINE_X86)
+    if (!force_scalar)
+    {
+        if (HAS_AVX2)
+        {
+            error ? encode_avx2<true>(view, payloads.data()) : encode_avx2<false>(view, payloads.data());
+        }
+        else
+        {
+            error ? encode_sse<true>(view, payloads.data()) : encode_sse<false>(view, payloads.data());
+        }
+        return;
+    }
+#endif
+    error ? encode_scalar_view<true>(view, payloads.data()) : encode_scalar_view<false>(view, payloads.data());
+}
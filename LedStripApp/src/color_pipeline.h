@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Transfer curve applied between brightness scaling and quantization
+enum class ColorCurve : uint8_t
+{
+	LINEAR = 0,
+	GAMMA_2_2 = 1,
+	CIE_LSTAR = 2 // Input is perceived lightness, evenly spaced steps look evenly spaced
+};
+
+// Ready to send 0x56 color command
+using ColorPayload = std::array<uint8_t, 7>;
+
+// Per channel rounding residue in 1/256 of a level, carried from one frame to the next
+using DitherError = std::array<int32_t, 3>;
+
+namespace color_pipeline
+{
+	inline const char* curve_strings[] = { "Linear", "Gamma 2.2", "CIE L*" };
+
+	// Single color, same result as a batch of one
+	ColorPayload encode(const std::array<float, 3>& color, float brightness, ColorCurve curve = ColorCurve::LINEAR);
+	// Temporal dithering, only worth it when frames are sent fast enough for the eye to average them
+	ColorPayload encode_dithered(const std::array<float, 3>& color, float brightness, ColorCurve curve, DitherError& error);
+}
+
+// Structure-of-arrays color buffer for many controllers. encode() scales by brightness, applies the
+// transfer curve and quantizes every entry in one pass, using AVX2 or SSE2 when the CPU has them.
+class ColorBatch
+{
+public:
+	ColorBatch() = default;
+	~ColorBatch() = default;
+
+	void resize(size_t count);
+	inline size_t size() const { return m_count; }
+	void set(size_t index, const std::array<float, 3>& color, float brightness, ColorCurve curve = ColorCurve::LINEAR);
+
+	// payloads[i] belongs to entry i
+	void encode(std::vector<ColorPayload>& payloads) const;
+	void encode_scalar(std::vector<ColorPayload>& payloads) const; // Reference path
+	// Same, with temporal dithering against the error each entry carried from the previous call
+	void encode_dithered(std::vector<ColorPayload>& payloads);
+	void encode_dithered_scalar(std::vector<ColorPayload>& payloads);
+	void reset_dither();
+	// Residue of one entry, for callers whose entries change from one frame to the next
+	void set_error(size_t index, const DitherError& error);
+	DitherError error(size_t index) const;
+
+private:
+	void encode_batch(std::vector<ColorPayload>& payloads, int32_t* const* error, bool force_scalar) const;
+
+	static constexpr size_t LANES = 8; // Arrays are padded so the vector kernels never need a tail
+
+	size_t m_count = 0;
+	std::vector<float> m_red;
+	std::vector<float> m_green;
+	std::vector<float> m_blue;
+	std::vector<float> m_brightness;
+	std::vector<int32_t> m_curve_offset; // Start of the entry's curve in the shared table
+	std::array<std::vector<int32_t>, 3> m_error; // Dither residue per channel
+};
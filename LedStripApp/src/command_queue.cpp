@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <ranges>
+
+#include "command_queue.h"
+#include "controller_group.h"
+
+namespace
+{
+    void replace_tracker(LEDCommand& command, std::shared_ptr<FanOutTracker> tracker)
+    {
+        if (command.tracker && command.tracker != tracker)
+        {
+            command.tracker->drop();
+        }
+        command.tracker = std::move(tracker);
+    }
+}
+
+bool CommandQueue::push(CommandType type, const SimpleBLE::ByteArray& payload, std::shared_ptr<FanOutTracker> tracker)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::optional<SimpleBLE::ByteArray>& acknowledged = m_acknowledged[static_cast<size_t>(type)];
+
+    if (type != CommandType::POWER)
+    {
+        // Latest color/mode wins, keep the position of the pending one
+        auto it = std::ranges::find(m_commands, type, &LEDCommand::type);
+        if (it != m_commands.end())
+        {
+            if (acknowledged == payload)
+            {
+                replace_tracker(*it, nullptr);
+                m_commands.erase(it); // Back to what the device already shows
+                return false;
+            }
+            it->payload = payload;
+            replace_tracker(*it, std::move(tracker));
+            return true;
+        }
+        if (acknowledged == payload)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // Compare against the state the device ends up in once pending power commands are written
+        auto it = std::find_if(m_commands.rbegin(), m_commands.rend(), [](const LEDCommand& command)
+            { return command.type == CommandType::POWER; }
+        );
+        const std::optional<SimpleBLE::ByteArray> expected = it != m_commands.rend() ? it->payload : acknowledged;
+        if (expected == payload)
+        {
+            return false;
+        }
+
+        if (m_commands.size() >= m_capacity && it != m_commands.rend())
+        {
+            // Queue is full of power commands, the newest one replaces the last pending one
+            it->payload = payload;
+            replace_tracker(*it, std::move(tracker));
+            return true;
+        }
+    }
+
+    m_commands.push_back({ type, payload, std::move(tracker) });
+    return true;
+}
+
+std::optional<LEDCommand> CommandQueue::try_pop(const std::function<bool(CommandType)>& can_send)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::ranges::find_if(m_commands, [&can_send](const LEDCommand& command)
+        { return can_send(command.type); }
+    );
+    if (it == m_commands.end())
+    {
+        return std::nullopt;
+    }
+
+    LEDCommand command = std::move(*it);
+    m_commands.erase(it);
+    return command;
+}
+
+bool CommandQueue::empty()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_commands.empty();
+}
+
+void CommandQueue::acknowledge(const LEDCommand& command)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_acknowledged[static_cast<size_t>(command.type)] = command.payload;
+}
+
+void CommandQueue::forget(CommandType type)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_acknowledged[static_cast<size_t>(type)] = std::nullopt;
+}
+
+void CommandQueue::forget_acknowledged()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_acknowledged.fill(std::nullopt);
+}
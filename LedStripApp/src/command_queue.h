@@ -0,0 +1,54 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <functional>
+#include <array>
+#include <memory>
+
+#include "simpleble/Types.h"
+
+enum class CommandType
+{
+	POWER,
+	COLOR,
+	MODE,
+};
+constexpr size_t COMMAND_TYPE_COUNT = 3;
+
+class FanOutTracker;
+
+struct LEDCommand
+{
+	CommandType type;
+	SimpleBLE::ByteArray payload;
+	std::shared_ptr<FanOutTracker> tracker = nullptr; // Set when queued by a group fan-out
+};
+
+// Bounded queue of pending writes for a single controller.
+// Color and mode commands coalesce into the pending command of the same type (latest wins),
+// power commands keep their order so on/off sequences reach the device as issued.
+// It also shadows the last payload the device confirmed per type, commands the device already has are dropped.
+class CommandQueue
+{
+public:
+	explicit CommandQueue(size_t capacity = 8) : m_capacity(capacity) {}
+	~CommandQueue() = default;
+
+	// Returns false if the command was dropped because it would not change the device state.
+	// A pending command that gets replaced or dropped reports that to its tracker.
+	bool push(CommandType type, const SimpleBLE::ByteArray& payload, std::shared_ptr<FanOutTracker> tracker = nullptr);
+	// Pops the oldest command whose type passes can_send, commands held back keep coalescing
+	std::optional<LEDCommand> try_pop(const std::function<bool(CommandType)>& can_send);
+	bool empty();
+	void acknowledge(const LEDCommand& command); // Payload reached the device
+	void forget(CommandType type); // Unknown whether the device shows the last payload of this type
+	void forget_acknowledged(); // Device state is unknown, e.g. after a fresh connect
+
+private:
+	std::mutex m_mutex;
+	std::deque<LEDCommand> m_commands;
+	std::array<std::optional<SimpleBLE::ByteArray>, COMMAND_TYPE_COUNT> m_acknowledged;
+	size_t m_capacity;
+};
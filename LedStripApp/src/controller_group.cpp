@@ -0,0 +1,78 @@
+#include <iostream>
+
+#include "controller_group.h"
+
+FanOutTracker::FanOutTracker(std::string group_name, size_t member_count)
+    : group_name(group_name), member_count(member_count), submitted(clock::now())
+{
+}
+
+void FanOutTracker::track()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tracked++;
+}
+
+void FanOutTracker::acknowledge()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const clock::time_point now = clock::now();
+    if (m_acknowledged == 0)
+    {
+        m_first_ack = now;
+    }
+    m_last_ack = now;
+    m_acknowledged++;
+    report_if_complete();
+}
+
+void FanOutTracker::drop()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dropped++;
+    report_if_complete();
+}
+
+void FanOutTracker::seal()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sealed = true;
+    report_if_complete();
+}
+
+bool FanOutTracker::is_complete() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sealed && m_acknowledged + m_dropped == m_tracked;
+}
+
+size_t FanOutTracker::acknowledged() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_acknowledged;
+}
+
+size_t FanOutTracker::dropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+std::chrono::nanoseconds FanOutTracker::skew() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_acknowledged == 0 ? std::chrono::nanoseconds(0) : m_last_ack - m_first_ack;
+}
+
+void FanOutTracker::report_if_complete()
+{
+    // Called with the mutex held
+    if (!m_sealed || m_acknowledged + m_dropped != m_tracked)
+    {
+        return;
+    }
+
+    const double skew_ms = std::chrono::duration<double, std::milli>(m_last_ack - m_first_ack).count();
+    std::cout << "[Info] Group \'" << group_name << "\' updated: " << m_acknowledged << " of " << m_tracked << " writes to "
+        << member_count << " controllers acknowledged, skew " << (m_acknowledged == 0 ? 0.0 : skew_ms) << " ms." << std::endl;
+}
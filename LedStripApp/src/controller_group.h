@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+// Named set of controllers that scene changes are sent to together, members are controller names
+struct ControllerGroup
+{
+	std::string name;
+	std::vector<std::string> members;
+};
+
+// Collects the outcome of every write queued by one group fan-out. Shared by the queued
+// commands, each reports back from its controller's strand when it is written or dropped.
+class FanOutTracker
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	explicit FanOutTracker(std::string group_name, size_t member_count);
+	~FanOutTracker() = default;
+
+	void track(); // A write is about to be queued
+	void acknowledge(); // It reached the device
+	void drop(); // Lost, superseded or already in place, it no longer counts
+	void seal(); // Everything has been queued
+
+	bool is_complete() const;
+	size_t acknowledged() const;
+	size_t dropped() const;
+	std::chrono::nanoseconds skew() const; // Between the first and the last acknowledged write
+
+public:
+	const std::string group_name;
+	const size_t member_count;
+	const clock::time_point submitted;
+
+private:
+	void report_if_complete();
+
+private:
+	mutable std::mutex m_mutex;
+	size_t m_tracked = 0;
+	size_t m_acknowledged = 0;
+	size_t m_dropped = 0;
+	bool m_sealed = false;
+	clock::time_point m_first_ack;
+	clock::time_point m_last_ack;
+};
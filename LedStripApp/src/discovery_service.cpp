@@ -0,0 +1,185 @@
+#include <iostream>
+#include <algorithm>
+
+#include "discovery_service.h"
+#include "simpleble_transport.h"
+
+bool DiscoveryService::bluetooth_enabled()
+{
+    return SimpleBLE::Adapter::bluetooth_enabled();
+}
+
+std::unique_ptr<BLETransport> DiscoveryService::find(const std::string& identifier)
+{
+    if (is_simulated(identifier))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        SimulationProfile profile = m_simulation_profile;
+        profile.seed ^= static_cast<uint32_t>(std::hash<std::string>{}(identifier)); // Distinct but repeatable per device
+        return std::make_unique<SimulatedPeripheral>(identifier, profile);
+    }
+
+    if (std::optional<SimpleBLE::Peripheral> peripheral = find_peripheral(identifier))
+    {
+        return std::make_unique<SimpleBLETransport>(*peripheral);
+    }
+    return nullptr;
+}
+
+std::optional<SimpleBLE::Peripheral> DiscoveryService::find_peripheral(const std::string& identifier)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (std::optional<SimpleBLE::Peripheral> peripheral = cached(identifier))
+    {
+        return peripheral;
+    }
+
+    m_requested[identifier]++;
+    if (m_scanning)
+    {
+        // Someone else is already scanning, which now also waits for this peripheral
+        const unsigned long long scan_count = m_scan_count;
+        m_condition.wait(lock, [this, &identifier, scan_count]()
+            { return cached(identifier).has_value() || m_scan_count != scan_count; }
+        );
+    }
+    else
+    {
+        scan(lock);
+    }
+    if (--m_requested[identifier] == 0)
+    {
+        m_requested.erase(identifier);
+    }
+
+    std::optional<SimpleBLE::Peripheral> peripheral = cached(identifier);
+    if (peripheral && m_time_to_discovery.contains(identifier))
+    {
+        std::cout << "[Info] Discovered \'" << identifier << "\' after " << m_time_to_discovery[identifier].count() << " ms." << std::endl;
+    }
+    return peripheral;
+}
+
+void DiscoveryService::forget(const std::string& identifier)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cache.erase(identifier);
+}
+
+void DiscoveryService::set_scan_timeout(clock::duration timeout)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_scan_timeout = timeout;
+}
+
+std::optional<std::chrono::milliseconds> DiscoveryService::time_to_discovery(const std::string& identifier)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_time_to_discovery.find(identifier);
+    if (it == m_time_to_discovery.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void DiscoveryService::set_simulation_profile(const SimulationProfile& profile)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_simulation_profile = profile;
+}
+
+bool DiscoveryService::is_simulated(const std::string& identifier)
+{
+    return identifier.starts_with(SimulatedPeripheral::IDENTIFIER_PREFIX);
+}
+
+void DiscoveryService::init_adapters()
+{
+    if (m_adapters_initialized)
+    {
+        return;
+    }
+
+    m_adapters = SimpleBLE::Adapter::get_adapters();
+    for (SimpleBLE::Adapter& adapter : m_adapters)
+    {
+        adapter.set_callback_on_scan_found([this](SimpleBLE::Peripheral peripheral) { on_peripheral_seen(peripheral); });
+        adapter.set_callback_on_scan_updated([this](SimpleBLE::Peripheral peripheral) { on_peripheral_seen(peripheral); });
+    }
+    m_adapters_initialized = true;
+}
+
+void DiscoveryService::scan(std::unique_lock<std::mutex>& lock)
+{
+    m_scanning = true;
+    m_scan_start = clock::now();
+    const clock::time_point deadline = m_scan_start + m_scan_timeout;
+    lock.unlock();
+
+    // Only the scanning thread touches the adapters
+    init_adapters();
+    if (m_adapters.empty())
+    {
+        std::cout << "[Warning] No bluetooth adapters found!" << std::endl;
+    }
+    else
+    {
+        std::cout << "[Info] Scanning on " << m_adapters.size() << " adapter(s)..." << std::endl;
+    }
+    for (SimpleBLE::Adapter& adapter : m_adapters)
+    {
+        adapter.scan_start();
+    }
+
+    lock.lock();
+    if (!m_adapters.empty())
+    {
+        m_condition.wait_until(lock, deadline, [this]() { return all_requested_found(); });
+    }
+    lock.unlock();
+
+    for (SimpleBLE::Adapter& adapter : m_adapters)
+    {
+        adapter.scan_stop();
+    }
+
+    lock.lock();
+    m_scanning = false;
+    m_scan_count++;
+    m_condition.notify_all();
+}
+
+void DiscoveryService::on_peripheral_seen(SimpleBLE::Peripheral peripheral)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const clock::time_point now = clock::now();
+    const std::string identifier = peripheral.identifier();
+
+    auto it = m_cache.find(identifier);
+    const bool first_sighting = it == m_cache.end() || it->second.last_seen < m_scan_start;
+    m_cache[identifier] = { peripheral, now };
+
+    if (first_sighting && m_requested.contains(identifier))
+    {
+        m_time_to_discovery[identifier] = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_scan_start);
+        m_condition.notify_all();
+    }
+}
+
+std::optional<SimpleBLE::Peripheral> DiscoveryService::cached(const std::string& identifier)
+{
+    auto it = m_cache.find(identifier);
+    if (it == m_cache.end() || clock::now() - it->second.last_seen > CACHE_LIFETIME)
+    {
+        return std::nullopt;
+    }
+    return it->second.peripheral;
+}
+
+bool DiscoveryService::all_requested_found()
+{
+    return std::ranges::all_of(m_requested, [this](const auto& request)
+        { return cached(request.first).has_value(); }
+    );
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "simpleble/SimpleBLE.h"
+#include "ble_transport.h"
+#include "simulated_peripheral.h"
+
+// Runs bluetooth scans on behalf of all controllers. One scan covers every available adapter and
+// fills a cache of identifier -> peripheral, concurrent connect requests share the same scan window.
+// A scan stops as soon as every requested peripheral has been seen, or after the scan timeout.
+// Identifiers starting with SimulatedPeripheral::IDENTIFIER_PREFIX resolve to simulated devices.
+class DiscoveryService
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	DiscoveryService() = default;
+	~DiscoveryService() = default;
+
+	bool bluetooth_enabled();
+	// Blocks while a scan is needed, returns a transport to the peripheral if it was seen recently enough
+	std::unique_ptr<BLETransport> find(const std::string& identifier);
+	// Drops a cached peripheral, e.g. after failing to connect to it
+	void forget(const std::string& identifier);
+	void set_scan_timeout(clock::duration timeout);
+	// Time from scan start until the peripheral was first seen, for the last scan that looked for it
+	std::optional<std::chrono::milliseconds> time_to_discovery(const std::string& identifier);
+	void set_simulation_profile(const SimulationProfile& profile);
+	static bool is_simulated(const std::string& identifier);
+
+	static constexpr std::chrono::seconds DEFAULT_SCAN_TIMEOUT{ 10 };
+	static constexpr std::chrono::seconds CACHE_LIFETIME{ 30 };
+
+private:
+	struct CacheEntry
+	{
+		SimpleBLE::Peripheral peripheral;
+		clock::time_point last_seen;
+	};
+
+	std::optional<SimpleBLE::Peripheral> find_peripheral(const std::string& identifier);
+	void init_adapters();
+	void scan(std::unique_lock<std::mutex>& lock);
+	void on_peripheral_seen(SimpleBLE::Peripheral peripheral);
+	std::optional<SimpleBLE::Peripheral> cached(const std::string& identifier);
+	bool all_requested_found();
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_condition; // Signaled when a requested peripheral is seen and when a scan ends
+	std::map<std::string, CacheEntry> m_cache;
+	std::map<std::string, int> m_requested; // Identifier -> number of callers waiting for it
+	std::map<std::string, std::chrono::milliseconds> m_time_to_discovery;
+	std::vector<SimpleBLE::Adapter> m_adapters;
+	bool m_adapters_initialized = false;
+	bool m_scanning = false;
+	unsigned long long m_scan_count = 0;
+	clock::time_point m_scan_start;
+	clock::duration m_scan_timeout = DEFAULT_SCAN_TIMEOUT;
+	SimulationProfile m_simulation_profile;
+};
@@ -0,0 +1,68 @@
+#include "durable_file.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace durable_file
+{
+    std::FILE* open(const std::filesystem::path& path, bool truncate)
+    {
+#if defined(_WIN32)
+        return _wfopen(path.c_str(), truncate ? L"wb" : L"ab");
+#else
+        return std::fopen(path.c_str(), truncate ? "wb" : "ab");
+#endif
+    }
+
+    void sync(std::FILE* file)
+    {
+        std::fflush(file);
+#if defined(_WIN32)
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+    }
+
+    bool replace(const std::filesystem::path& from, const std::filesystem::path& to)
+    {
+#if defined(_WIN32)
+        return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        std::error_code error;
+        std::filesystem::rename(from, to, error);
+        return !error;
+#endif
+    }
+
+    bool write_atomically(const std::filesystem::path& path, const void* data, size_t size)
+    {
+        std::filesystem::path temp_path = path;
+        temp_path += ".tmp";
+
+        std::FILE* file = open(temp_path, true);
+        if (!file)
+        {
+            return false;
+        }
+        const bool written = std::fwrite(data, 1, size, file) == size;
+        sync(file);
+        std::fclose(file);
+        return written && replace(temp_path, path);
+    }
+
+    uint32_t checksum(const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+}
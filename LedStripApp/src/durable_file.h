@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Small wrappers for files that have to survive a crash or power loss
+namespace durable_file
+{
+	std::FILE* open(const std::filesystem::path& path, bool truncate); // Binary, appends unless truncating
+	void sync(std::FILE* file); // Flushes the stream and the OS cache to the disk
+	bool replace(const std::filesystem::path& from, const std::filesystem::path& to); // Atomic rename over an existing file
+	bool write_atomically(const std::filesystem::path& path, const void* data, size_t size); // Via a synced <path>.tmp and replace
+	uint32_t checksum(const void* data, size_t size); // FNV-1a, to tell torn or corrupt data apart
+}
@@ -3,13 +3,16 @@
 #include <string>
 #include <array>
 
+#include "color_pipeline.h"
+#include "slot_map.h"
+
 class Mode
 {
 public:
 	Mode() = default;
 	Mode(int index, float speed) : index(index), speed(speed) {}
 
-	inline char get_mode() { return (index >= 0 && index < mode_bytes.size()) ? mode_bytes.at(index) : 0; };
+	inline char get_mode() const { return (index >= 0 && index < mode_bytes.size()) ? mode_bytes.at(index) : 0; };
 
 public:
 	int index;
@@ -44,4 +47,7 @@ public:
 	std::array<float, 3> color;
 	float brightness;
 	Mode mode;
+	ColorCurve curve = ColorCurve::LINEAR; // How brightness and color values map to PWM duty
 };
+
+using LEDConfigHandle = SlotMap<LEDConfiguration>::Handle;
@@ -1,32 +1,46 @@
 #include "led_controller.h"
 #include "app.h"
-#include "simpleble/Exceptions.h"
+#include "settings_snapshot.h"
 #include <iostream>
 #include <algorithm>
 
 LEDController::LEDController(App* app, std::string name, bool timer_enabled) 
-    : m_app(app), m_name(name), m_alias(m_name), m_timer_enabled(timer_enabled)
+    : m_app(app), m_name(name), m_alias(m_name), m_timer_enabled(timer_enabled), m_rate_limiter(ControllerSettings::DEFAULT_COMMAND_RATE, 2.0f)
 {
     m_connection_status = BLESTATUS::UNDEFINED;
     m_is_scanning = false;
-    m_peripheral = nullptr;
+    m_is_shutting_down = false;
+    m_reconnect_attempts = 0;
+    m_backoff_rng.seed(std::random_device{}());
+    m_drain_scheduled = false;
+    m_paced_drain_scheduled = false;
+    m_streaming_enabled = true;
+    m_max_command_rate = ControllerSettings::DEFAULT_COMMAND_RATE;
+    m_dithering_enabled = true;
+    m_supports_write_command = false;
+    m_streamed_writes = 0;
+    m_pending_timer_state = -1;
+    m_strand = m_app->m_ble_scheduler.make_strand();
 }
 
 LEDController::~LEDController()
 {
-    if (m_scanning_thread.joinable())
+    m_is_shutting_down = true; // The disconnect below must not trigger a reconnect
+    m_app->m_animation_player.stop(this);
+    m_app->m_ble_scheduler.submit(m_strand, [this]() { drain_commands(true); });
+    m_app->m_ble_scheduler.close(m_strand); // Waits for the flush above
+    if (std::shared_ptr<BLETransport> transport = m_transport.exchange(nullptr))
     {
-        m_scanning_thread.join();
-    }
-    if (m_command_thread.joinable())
-    {
-        m_command_thread.join();
-    }
-    if (m_peripheral != nullptr) 
-    {
-        m_peripheral->disconnect();
-        delete m_peripheral;
-        m_peripheral = nullptr; // Avoid dangling pointer
+        // The peripheral stays cached in the discovery service and outlives this controller
+        transport->set_callback_on_disconnected({});
+        try
+        {
+            transport->disconnect();
+        }
+        catch (const TransportError& e)
+        {
+            std::cout << "[Warning] Failed to disconnect controller \'" << m_name << "\': " << e.what() << std::endl;
+        }
     }
 }
 
@@ -36,7 +50,9 @@ void LEDController::scan_and_connect()
     {
         return;
     }
-    m_scanning_thread = std::thread(&LEDController::scan_and_connect_internal, this);
+    m_is_scanning = true;
+    publish_state(); // Replayed once connected
+    m_app->m_ble_scheduler.submit(m_strand, [this]() { scan_and_connect_internal(); }, BLEScheduler::Lane::BLOCKING);
 }
 
 void LEDController::toggle_device()
@@ -45,51 +61,226 @@ void LEDController::toggle_device()
     set_device_on(led_config()->device_on);
 }
 
-void LEDController::write_command(SimpleBLE::ByteArray& command)
+void LEDController::apply_timer_state(bool on)
 {
-    if (!is_connected())
+    m_pending_timer_state = on ? 1 : 0;
+    write_command(CommandType::POWER, on ? TURN_ON_COMMAND : TURN_OFF_COMMAND);
+}
+
+void LEDController::play_animation(std::shared_ptr<const Animation> animation)
+{
+    m_animation = animation;
+    publish_state(); // Brightness and curve of the frames
+    m_app->m_animation_player.play(this, animation);
+}
+
+void LEDController::stop_animation()
+{
+    if (m_animation.exchange(nullptr))
     {
-        m_connection_status = BLESTATUS::BLE_PERIPHERAL_NOT_CONNECTED;
-        std::cout << "[Warning] Cannot write to unconnected controller \'" << m_name << "\'." << std::endl;
-        return;
+        // Back to the configured color, no frame is queued after it
+        m_app->m_animation_player.stop(this);
+        update_rgb();
     }
-    
-    if (m_is_writing_command.load())
+}
+
+void LEDController::sync_timer_state()
+{
+    const int pending = m_pending_timer_state.exchange(-1);
+    if (pending < 0)
     {
-        std::cout << "[Debug] Writing command is busy. Skipping for \'" << m_name << "\'." << std::endl;
         return;
     }
+    led_config()->device_on = pending == 1;
+    publish_state();
+}
+
+std::shared_ptr<FanOutTracker> LEDController::fan_out(const std::string& group_name, const std::vector<LEDController*>& members)
+{
+    std::shared_ptr<FanOutTracker> tracker = std::make_shared<FanOutTracker>(group_name, members.size());
+    if (members.empty())
+    {
+        tracker->seal();
+        return tracker;
+    }
+
+    // One encoding serves all members, they all get the first member's state
+    LEDController* first = members.front();
+    const DeviceState state = first->publish_state();
+    const std::array<std::pair<CommandType, SimpleBLE::ByteArray>, COMMAND_TYPE_COUNT> commands = { {
+        { CommandType::POWER, state.device_on ? first->TURN_ON_COMMAND : first->TURN_OFF_COMMAND },
+        { CommandType::COLOR, first->encode_color(state) },
+        { CommandType::MODE, first->encode_mode(state) }
+    } };
+
+    // Everything is queued before any drain starts, then the drains go out as one batch
+    std::vector<std::pair<std::shared_ptr<BLEScheduler::Strand>, BLEScheduler::Job>> drains;
+    for (LEDController* member : members)
+    {
+        if (member != first)
+        {
+            member->publish(state);
+        }
+        bool needs_drain = false;
+        for (const auto& [type, payload] : commands)
+        {
+            needs_drain |= member->queue_command(type, payload, tracker);
+        }
+        if (needs_drain)
+        {
+            drains.push_back({ member->m_strand, [member]() { member->drain_commands(); } });
+        }
+    }
+    tracker->seal();
+    first->m_app->m_ble_scheduler.submit_batch(std::move(drains));
+    return tracker;
+}
 
-    m_is_writing_command.store(true);
-    if (m_command_thread.joinable()) {
-        m_command_thread.join(); // Wait for the previous thread to finish
+void LEDController::write_command(CommandType type, const SimpleBLE::ByteArray& command)
+{
+    if (queue_command(type, command, nullptr))
+    {
+        m_app->m_ble_scheduler.submit(m_strand, [this]() { drain_commands(); });
     }
-    m_command_thread = std::thread([this, command]() {
+}
+
+bool LEDController::queue_command(CommandType type, const SimpleBLE::ByteArray& command, std::shared_ptr<FanOutTracker> tracker)
+{
+    if (tracker)
+    {
+        tracker->track();
+    }
+
+    if (!is_connected())
+    {
+        if (m_connection_status != BLESTATUS::RECONNECTING)
+        {
+            m_connection_status = BLESTATUS::BLE_PERIPHERAL_NOT_CONNECTED;
+        }
+        std::cout << "[Warning] Cannot write to unconnected controller \'" << m_name << "\'." << std::endl;
+        if (tracker)
+        {
+            tracker->drop();
+        }
+        return false;
+    }
+
+    if (!m_command_queue.push(type, command, tracker))
+    {
+        if (tracker)
+        {
+            tracker->drop(); // Device already has this state
+        }
+        return false;
+    }
+    if (is_paced(type) && m_paced_drain_scheduled)
+    {
+        return false; // The pending paced drain sends the latest value
+    }
+    return !m_drain_scheduled.exchange(true);
+}
+
+void LEDController::drain_commands(bool flush)
+{
+    m_drain_scheduled = false; // Commands pushed from here on either get popped below or schedule a new drain
+    m_rate_limiter.set_rate(m_max_command_rate);
+    auto can_send = [this, flush](CommandType type) -> bool
+    {
+        return flush || !is_paced(type) || m_rate_limiter.try_acquire();
+    };
+
+    while (std::optional<LEDCommand> command = m_command_queue.try_pop(can_send))
+    {
+        if (!is_connected())
+        {
+            if (command->tracker)
+            {
+                command->tracker->drop();
+            }
+            continue; // Dropped, the state is replayed once the reconnect succeeds
+        }
+
         try
         {
-            m_peripheral->write_request(WRITE_SERVICE, WRITE_CHARACTERISTIC, command);
-            std::cout << "[Debug] Command successfully written to LED controller." << std::endl;
+            if (write_to_peripheral(*command))
+            {
+                m_command_queue.acknowledge(*command);
+            }
+            else
+            {
+                // A streamed write may get lost, the same payload must not be suppressed after it
+                m_command_queue.forget(command->type);
+            }
+            if (command->tracker)
+            {
+                command->tracker->acknowledge();
+            }
         }
-        catch (const SimpleBLE::Exception::BaseException& e)
+        catch (const TransportError& e)
         {
+            if (command->tracker)
+            {
+                command->tracker->drop();
+            }
+            m_command_queue.forget(command->type); // The write may or may not have reached the device
+            if (command->type == CommandType::COLOR)
+            {
+                // A failing sync write means streamed writes may have been lost as well
+                m_streaming_blocked_until = std::chrono::steady_clock::now() + STREAMING_FALLBACK_DURATION;
+            }
             std::cerr << "[Error] Exception during write request: " << e.what() << std::endl;
         }
-        m_is_writing_command.store(false);
-    });
+    }
+
+    if (!m_command_queue.empty() && !m_paced_drain_scheduled.exchange(true))
+    {
+        // Out of budget, send whatever is latest once the bucket has a token again
+        m_app->m_ble_scheduler.submit_after(m_strand, m_rate_limiter.time_until_available(), [this]() {
+            m_paced_drain_scheduled = false;
+            drain_commands();
+        });
+    }
 }
 
-bool LEDController::is_connected()
+bool LEDController::is_paced(CommandType type) const
 {
-    return m_peripheral != nullptr && m_peripheral->is_connected();
+    return type == CommandType::COLOR || type == CommandType::MODE;
 }
 
-void LEDController::try_join_scanning_thread()
+bool LEDController::write_to_peripheral(const LEDCommand& command)
 {
-    if (m_is_scanning || !m_scanning_thread.joinable())
+    std::shared_ptr<BLETransport> transport = m_transport.load();
+    if (can_stream(command) && ++m_streamed_writes % STREAMING_SYNC_INTERVAL != 0)
     {
-        return;
+        try
+        {
+            transport->write_command(WRITE_SERVICE, WRITE_CHARACTERISTIC, command.payload);
+            return false;
+        }
+        catch (const TransportError& e)
+        {
+            m_streaming_blocked_until = std::chrono::steady_clock::now() + STREAMING_FALLBACK_DURATION;
+            std::cout << "[Warning] Write without response failed for \'" << m_name << "\', falling back to write requests: " << e.what() << std::endl;
+        }
     }
-    m_scanning_thread.join();
+
+    transport->write_request(WRITE_SERVICE, WRITE_CHARACTERISTIC, command.payload);
+    return true;
+}
+
+bool LEDController::can_stream(const LEDCommand& command)
+{
+    // Power and mode changes are rare and must not get lost, only color/brightness updates are streamed
+    return command.type == CommandType::COLOR &&
+        m_streaming_enabled &&
+        m_supports_write_command &&
+        std::chrono::steady_clock::now() >= m_streaming_blocked_until;
+}
+
+bool LEDController::is_connected()
+{
+    std::shared_ptr<BLETransport> transport = m_transport.load();
+    return transport != nullptr && transport->is_connected();
 }
 
 std::string LEDController::connection_status_str()
@@ -118,6 +309,9 @@ std::string LEDController::connection_status_str()
     case BLESTATUS::BLT_NOT_ENABLED:
         str = "Bluetooth is not enabled!";
         break;
+    case BLESTATUS::RECONNECTING:
+        str = "Connection lost, reconnecting...";
+        break;
     }
     
     return str;
@@ -125,26 +319,59 @@ std::string LEDController::connection_status_str()
 
 void LEDController::update_all()
 {
-    set_device_on(led_config()->device_on);
-    update_rgb();
-    update_mode();
+    const DeviceState state = publish_state();
+    write_command(CommandType::POWER, state.device_on ? TURN_ON_COMMAND : TURN_OFF_COMMAND);
+    write_command(CommandType::COLOR, encode_color(state));
+    write_command(CommandType::MODE, encode_mode(state));
 }
 
 void LEDController::set_device_on(bool on)
 {
-    SimpleBLE::ByteArray command = on ? TURN_ON_COMMAND : TURN_OFF_COMMAND;
-    write_command(command);
+    publish_state();
+    write_command(CommandType::POWER, on ? TURN_ON_COMMAND : TURN_OFF_COMMAND);
 }
 
 void LEDController::update_rgb()
 {
-    color_command[1] = static_cast<char>(led_config()->color[0] * led_config()->brightness * 255.000);
-    color_command[2] = static_cast<char>(led_config()->color[1] * led_config()->brightness * 255.000);
-    color_command[3] = static_cast<char>(led_config()->color[2] * led_config()->brightness * 255.000);
-    write_command(color_command);
+    write_command(CommandType::COLOR, encode_color(publish_state()));
 }
 
 void LEDController::update_mode()
+{
+    write_command(CommandType::MODE, encode_mode(publish_state()));
+}
+
+DeviceState LEDController::publish_state()
+{
+    const LEDConfiguration* config = led_config();
+    const DeviceState state = { config->device_on, config->color, config->brightness, config->mode, config->curve };
+    publish(state);
+    m_app->mark_led_config_changed(config);
+    return state;
+}
+
+void LEDController::publish(const DeviceState& state)
+{
+    m_state_channel.write(state);
+    m_animation_channel.write(state);
+}
+
+void LEDController::replay_state()
+{
+    // Runs on the strand, never touches the configurations the UI is editing
+    const DeviceState& state = m_state_channel.read();
+    write_command(CommandType::POWER, state.device_on ? TURN_ON_COMMAND : TURN_OFF_COMMAND);
+    write_command(CommandType::COLOR, encode_color(state));
+    write_command(CommandType::MODE, encode_mode(state));
+}
+
+SimpleBLE::ByteArray LEDController::encode_color(const DeviceState& state) const
+{
+    const ColorPayload payload = color_pipeline::encode(state.color, state.brightness, state.curve);
+    return SimpleBLE::ByteArray(payload.begin(), payload.end());
+}
+
+SimpleBLE::ByteArray LEDController::encode_mode(const DeviceState& state) const
 {
     using Range = std::pair<float, float>;
     auto interp1d = [](Range range_in, Range range_out, float input) -> float {
@@ -152,9 +379,10 @@ void LEDController::update_mode()
         return range_out.first + (input - range_in.first) * (range_out.second - range_out.first) / (range_in.second - range_in.first);
     };
 
-    mode_command[1] = static_cast<char>(led_config()->mode.get_mode());
-    mode_command[2] = static_cast<char>(interp1d({ 0.0, 1.0 }, { 1.0, 31.0 }, 1 - led_config()->mode.speed));
-    write_command(mode_command);
+    SimpleBLE::ByteArray command = MODE_COMMAND;
+    command[1] = static_cast<char>(state.mode.get_mode());
+    command[2] = static_cast<char>(interp1d({ 0.0, 1.0 }, { 1.0, 31.0 }, 1 - state.mode.speed));
+    return command;
 }
 
 void LEDController::scan_and_connect_internal()
@@ -163,9 +391,7 @@ void LEDController::scan_and_connect_internal()
     m_connection_status = BLESTATUS::SCANNING;
     std::cout << "[Info] Scanning for device..." << std::endl;
 
-    std::vector<SimpleBLE::Adapter> adapters = SimpleBLE::Adapter::get_adapters();
-    SimpleBLE::Adapter adapter = adapters[0];
-    if (!adapter.bluetooth_enabled())
+    if (!DiscoveryService::is_simulated(m_name) && !m_app->m_discovery.bluetooth_enabled())
     {
         m_is_scanning = false;
         m_connection_status = BLESTATUS::BLT_NOT_ENABLED;
@@ -173,73 +399,111 @@ void LEDController::scan_and_connect_internal()
         return;
     }
 
-    SimpleBLE::Peripheral peri;
-    bool device_found = false;
-    char* d_name = m_name.data();
-    adapter.set_callback_on_scan_found([&d_name, &peri, &device_found](SimpleBLE::Peripheral peripheral) mutable {
-        if (peripheral.identifier().compare(d_name) != 0)
-        {
-            return;
-        }
-
-        device_found = true;
-        peri = peripheral;
-        });
-
-    adapter.scan_start();
-    std::this_thread::sleep_for(std::chrono::seconds(5));
-    adapter.scan_stop();
-
-    if (!device_found)
+    std::shared_ptr<BLETransport> transport = m_app->m_discovery.find(m_name);
+    if (!transport)
     {
         m_connection_status = BLESTATUS::BLE_PERIPHERAL_NOT_FOUND;
         std::cout << "[Error] Could not find the peripheral!" << std::endl;
+        m_is_scanning = false;
+        return;
     }
-    else
+
+    try
+    {
+        transport->connect();
+    }
+    catch (const TransportError& e)
     {
-        m_peripheral = new SimpleBLE::Peripheral(peri);
-        m_peripheral->connect();
+        std::cout << "[Warning] Connect to controller \'" << m_name << "\' failed: " << e.what() << std::endl;
+    }
+    m_transport = transport; // Replaces the one left over from a previous failed attempt
 
-        if (is_connected())
-        {
-            m_connection_status = BLESTATUS::CONNECTED;
-            std::cout << "[Info] Connected to controller \'" << m_name << "\'." << std::endl;
-            update_all();
-        }
-        else
-        {
-            m_connection_status = BLESTATUS::FAILED_TO_CONNECT;
-            std::cout << "[Error] Failed to connect to controller \'" << m_name << "\'." << std::endl;
-        }
+    if (is_connected())
+    {
+        m_reconnect_attempts = 0;
+        m_command_queue.forget_acknowledged(); // Fresh connection, the device state is unknown
+        m_supports_write_command = transport->can_write_command(WRITE_SERVICE, WRITE_CHARACTERISTIC);
+        transport->set_callback_on_disconnected([this]() { on_disconnected(); });
+        on_connected();
+    }
+    else
+    {
+        m_app->m_discovery.forget(m_name);
+        m_connection_status = BLESTATUS::FAILED_TO_CONNECT;
+        std::cout << "[Error] Failed to connect to controller \'" << m_name << "\'." << std::endl;
     }
     m_is_scanning = false;
 }
 
-LEDConfiguration* LEDController::led_config()
+void LEDController::on_connected()
 {
-    try
-    {
-        int index = m_app->m_selected_led_configs.at(m_name);
-        return m_app->m_led_configs.at(index).get();
-    }
-    catch (const std::out_of_range& e)
+    m_connection_status = BLESTATUS::CONNECTED;
+    std::cout << "[Info] Connected to controller \'" << m_name << "\'." << std::endl;
+    replay_state();
+}
+
+void LEDController::on_disconnected()
+{
+    // Called from the bluetooth backend's thread
+    if (m_is_shutting_down)
     {
-        std::cout << "Failed to find led config for controller \'" << m_name << "\': " << e.what() << std::endl;
-        return nullptr;
+        return;
     }
+
+    std::cout << "[Warning] Lost connection to controller \'" << m_name << "\'." << std::endl;
+    m_connection_status = BLESTATUS::RECONNECTING;
+    m_app->m_ble_scheduler.submit(m_strand, [this]() { schedule_reconnect(); });
 }
 
-TimerConfiguration* LEDController::timer_config()
+void LEDController::schedule_reconnect()
+{
+    // Full jitter keeps many strips dropped at once from reconnecting in lockstep
+    const int exponent = std::min(m_reconnect_attempts, 16);
+    const auto max_delay = std::min<std::chrono::milliseconds>(RECONNECT_BASE_DELAY * (1LL << exponent), RECONNECT_MAX_DELAY);
+    std::uniform_int_distribution<long long> distribution(max_delay.count() / 2, max_delay.count());
+    const std::chrono::milliseconds delay(distribution(m_backoff_rng));
+    m_reconnect_attempts++;
+
+    std::cout << "[Info] Reconnecting to controller \'" << m_name << "\' in " << delay.count() << " ms (attempt " << m_reconnect_attempts << ")." << std::endl;
+    m_app->m_ble_scheduler.submit_after(m_strand, delay, [this]() { reconnect_internal(); }, BLEScheduler::Lane::BLOCKING);
+}
+
+void LEDController::reconnect_internal()
 {
+    std::shared_ptr<BLETransport> transport = m_transport.load();
+    if (is_connected() || m_is_scanning || transport == nullptr)
+    {
+        return; // Reconnected by other means in the meantime
+    }
+
     try
     {
-        int index = m_app->m_selected_timer_configs.at(m_name);
-        return m_app->m_timer_configs.at(index).get();
+        transport->connect();
+    }
+    catch (const TransportError& e)
+    {
+        std::cout << "[Warning] Reconnect to controller \'" << m_name << "\' failed: " << e.what() << std::endl;
     }
-    catch (const std::out_of_range& e)
+
+    if (!is_connected())
     {
-        std::cout << "Failed to find timer config for controller \'" << m_name << "\': " << e.what() << std::endl;
-        return nullptr;
+        schedule_reconnect();
+        return;
     }
+
+    m_reconnect_attempts = 0;
+    on_connected(); // The device kept its state over the drop, only what changed meanwhile is written
+}
+
+LEDConfiguration* LEDController::led_config()
+{
+    LEDConfiguration* config = m_app->m_led_configs.get(m_led_config);
+    return config ? config : &m_app->m_led_configs[0];
+}
+
+TimerConfiguration* LEDController::timer_config()
+{
+    TimerConfiguration* config = m_app->m_timer_configs.get(m_timer_config);
+    return config ? config : &m_app->m_timer_configs[0];
 }
 
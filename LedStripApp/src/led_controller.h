@@ -5,10 +5,20 @@
 #include <vector>
 #include <array>
 #include <memory>
+#include <chrono>
+#include <random>
 
-#include "simpleble/SimpleBLE.h"
+#include "simpleble/Types.h"
+#include "ble_transport.h"
+#include "command_queue.h"
+#include "ble_scheduler.h"
+#include "rate_limiter.h"
+#include "triple_buffer.h"
 #include "led_configuration.h"
 #include "timer_configuration.h"
+#include "animation.h"
+#include "color_pipeline.h"
+#include "controller_group.h"
 
 enum BLESTATUS {
 	UNDEFINED,
@@ -18,6 +28,17 @@ enum BLESTATUS {
 	BLE_PERIPHERAL_NOT_FOUND,
 	BLE_PERIPHERAL_NOT_CONNECTED,
 	BLT_NOT_ENABLED,
+	RECONNECTING,
+};
+
+// Copy of what the device should show, handed from the UI thread to the bluetooth strand
+struct DeviceState
+{
+	bool device_on = false;
+	std::array<float, 3> color = { 1.0f, 1.0f, 1.0f };
+	float brightness = 1.0f;
+	Mode mode = { 0, 0.0f };
+	ColorCurve curve = ColorCurve::LINEAR;
 };
 
 class App;
@@ -33,40 +54,98 @@ public:
 	void update_rgb();
 	void update_mode();
 	void update_all();
-	void try_join_scanning_thread();
 	std::string connection_status_str();
 	bool is_connected();
 	inline bool is_scanning() const { return m_is_scanning; }
 	inline bool is_device_on() { return led_config()->device_on; }
+	void apply_timer_state(bool on); // Thread safe, called from the timer's scheduler thread
+	void sync_timer_state(); // Shows the last applied timer state in the UI
+	void play_animation(std::shared_ptr<const Animation> animation);
+	void stop_animation();
+	inline std::shared_ptr<const Animation> animation() const { return m_animation.load(); }
+	// Sends the first member's configuration to all of them at once, every member replays that state after a reconnect
+	static std::shared_ptr<FanOutTracker> fan_out(const std::string& group_name, const std::vector<LEDController*>& members);
 
-	LEDConfiguration* led_config();
+	LEDConfiguration* led_config(); // The default configuration when its own was deleted
 	TimerConfiguration* timer_config();
 
 private:
 	void set_device_on(bool on);
+	DeviceState publish_state();
+	void publish(const DeviceState& state);
+	void replay_state();
+	SimpleBLE::ByteArray encode_color(const DeviceState& state) const;
+	SimpleBLE::ByteArray encode_mode(const DeviceState& state) const;
 	void scan_and_connect_internal();
-	void write_command(SimpleBLE::ByteArray& command);
+	void on_connected();
+	void on_disconnected();
+	void schedule_reconnect();
+	void reconnect_internal();
+	void write_command(CommandType type, const SimpleBLE::ByteArray& command);
+	bool queue_command(CommandType type, const SimpleBLE::ByteArray& command, std::shared_ptr<FanOutTracker> tracker); // True if a drain has to be submitted
+	void drain_commands(bool flush = false);
+	bool is_paced(CommandType type) const;
+	bool write_to_peripheral(const LEDCommand& command); // True if the device confirmed the write
+	bool can_stream(const LEDCommand& command);
 
 public:
 	std::string m_name;
 	std::string m_alias;
 	bool m_timer_enabled;
+	std::atomic_bool m_streaming_enabled; // Send color updates as write-without-response
+	std::atomic<float> m_max_command_rate; // Color and mode commands per second
+	std::atomic_bool m_dithering_enabled; // Temporal dithering of animation frames
+	LEDConfigHandle m_led_config; // Default handles select the default configurations
+	TimerConfigHandle m_timer_config;
 	App* m_app;
 
+	static constexpr float MIN_COMMAND_RATE = 5.0f;
+	static constexpr float MAX_COMMAND_RATE = 60.0f;
+	static constexpr float DITHER_MIN_RATE = 24.0f; // Slower than this the dither shows as flicker
+
 private:
 	// Commands
 	const SimpleBLE::BluetoothUUID WRITE_SERVICE = "0000ffd5-0000-1000-8000-00805f9b34fb";
 	const SimpleBLE::BluetoothUUID WRITE_CHARACTERISTIC = "0000ffd9-0000-1000-8000-00805f9b34fb";
 	const SimpleBLE::ByteArray TURN_ON_COMMAND = { (char)0xCC, (char)0x23, (char)0x33 };
 	const SimpleBLE::ByteArray TURN_OFF_COMMAND = { (char)0xCC, (char)0x24, (char)0x33 };
-	SimpleBLE::ByteArray color_command = { (char)0x56, (char)0x00, (char)0x00, (char)0x00, (char)0x00, (char)0xF0, (char)0xAA };
-	SimpleBLE::ByteArray mode_command = { (char)0xBB, (char)0x00, (char)0x00, (char)0x44 };
+	const SimpleBLE::ByteArray MODE_COMMAND = { (char)0xBB, (char)0x00, (char)0x00, (char)0x44 };
+
+	// Written by the UI thread whenever it sends state, read by the strand to replay it after (re)connecting
+	TripleBuffer<DeviceState> m_state_channel;
+
+	// Last state sent by the timer and not yet shown in the UI, -1 if none
+	std::atomic_int m_pending_timer_state;
+
+	// Host side animation, its frames are encoded by the app's animation player and paced by the queue
+	friend class AnimationPlayer;
+	std::atomic<std::shared_ptr<const Animation>> m_animation;
+	TripleBuffer<DeviceState> m_animation_channel; // Same as m_state_channel, read by the player's tick
 
 	// Bluetooth Connection
-	SimpleBLE::Peripheral* m_peripheral;
-	BLESTATUS m_connection_status;
+	std::atomic<std::shared_ptr<BLETransport>> m_transport; // Replaced on the strand, read from the UI as well
+	std::atomic<BLESTATUS> m_connection_status;
 	std::atomic_bool m_is_scanning;
-	std::atomic_bool m_is_writing_command;
-	std::thread m_scanning_thread;
-	std::thread m_command_thread;
+	std::atomic_bool m_is_shutting_down;
+
+	// Reconnect supervisor, retries dropped links with jittered exponential backoff
+	static constexpr std::chrono::milliseconds RECONNECT_BASE_DELAY{ 500 };
+	static constexpr std::chrono::milliseconds RECONNECT_MAX_DELAY{ 30000 };
+	int m_reconnect_attempts; // Only touched from the strand
+	std::mt19937 m_backoff_rng;
+
+	// Scan, connect and writes run as jobs on this device's strand of the shared scheduler,
+	// writes are fed through a coalescing queue so the last user intent always reaches the strip
+	std::shared_ptr<BLEScheduler::Strand> m_strand;
+	CommandQueue m_command_queue;
+	std::atomic_bool m_drain_scheduled;
+	std::atomic_bool m_paced_drain_scheduled;
+	RateLimiter m_rate_limiter; // Only touched from the strand
+
+	// Color streaming, only touched from the strand
+	static constexpr int STREAMING_SYNC_INTERVAL = 8; // Every n-th streamed write is acknowledged
+	static constexpr std::chrono::seconds STREAMING_FALLBACK_DURATION{ 10 };
+	bool m_supports_write_command;
+	int m_streamed_writes;
+	std::chrono::steady_clock::time_point m_streaming_blocked_until;
 };
\ No newline at end of file
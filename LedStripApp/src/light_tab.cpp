@@ -1,6 +1,8 @@
 #include <vector>
 #include <ranges>
 #include <algorithm>
+#include <chrono>
+#include <format>
 
 #define NOMINMAX
 #include "light_tab.h"
@@ -52,6 +54,10 @@ void LightTab::render()
     if (ImGui::Begin("Bluetooth Connect")) {
         // Connect controller
         ImGui::Text(m_app->led_controller()->connection_status_str().c_str());
+        if (auto time_to_discovery = m_app->m_discovery.time_to_discovery(m_app->led_controller()->m_name))
+        {
+            ImGui::Text("Discovered after %lld ms", static_cast<long long>(time_to_discovery->count()));
+        }
         if (!m_app->led_controller()->is_scanning())
         {
             if (!m_app->led_controller()->is_connected())
@@ -63,6 +69,24 @@ void LightTab::render()
                 }
             }
         }
+        bool streaming_enabled = m_app->led_controller()->m_streaming_enabled;
+        if (ImGui::Checkbox("Fast color updates", &streaming_enabled))
+        {
+            m_app->led_controller()->m_streaming_enabled = streaming_enabled;
+            m_app->mark_controller_changed(m_app->led_controller());
+        }
+        float max_command_rate = m_app->led_controller()->m_max_command_rate;
+        if (ImGui::SliderFloat("Max update rate", &max_command_rate, LEDController::MIN_COMMAND_RATE, LEDController::MAX_COMMAND_RATE, "%.0f Hz"))
+        {
+            m_app->led_controller()->m_max_command_rate = max_command_rate;
+            m_app->mark_controller_changed(m_app->led_controller());
+        }
+        bool dithering_enabled = m_app->led_controller()->m_dithering_enabled;
+        if (ImGui::Checkbox("Dither animations", &dithering_enabled))
+        {
+            m_app->led_controller()->m_dithering_enabled = dithering_enabled;
+            m_app->mark_controller_changed(m_app->led_controller());
+        }
 
         // Known devices
         std::vector<const char*> controller_items;
@@ -123,6 +147,57 @@ void LightTab::render()
             m_app->led_controller()->m_alias = m_app->led_controller()->m_name;
         }
 
+        // Groups
+        std::vector<const char*> group_items;
+        for (const ControllerGroup& group : m_app->m_groups)
+        {
+            group_items.push_back(group.name.c_str());
+        }
+        m_selected_group = std::clamp(m_selected_group, 0, std::max(static_cast<int>(group_items.size()) - 1, 0));
+        ImGui::Text("Groups");
+        ImGui::Combo("Group", &m_selected_group, group_items.data(), static_cast<int>(group_items.size()));
+        ImGui::InputText("##New group", m_new_group_name, sizeof(m_new_group_name), ImGuiInputTextFlags_CharsNoBlank);
+        ImGui::SameLine();
+        if (ImGui::Button("Create group"))
+        {
+            const bool name_exists = std::ranges::find(m_app->m_groups, std::string(m_new_group_name), &ControllerGroup::name) != m_app->m_groups.end();
+            if (m_new_group_name[0] != '\0' && !name_exists && m_app->create_new_group(std::string(m_new_group_name)))
+            {
+                std::cout << "[Info] Creating new group '" << m_new_group_name << "'." << std::endl;
+                m_selected_group = static_cast<int>(m_app->m_groups.size()) - 1;
+            }
+        }
+        if (!m_app->m_groups.empty())
+        {
+            ControllerGroup& group = m_app->m_groups[m_selected_group];
+            bool is_member = helpers::exists_in_vector(group.members, m_app->led_controller()->m_name);
+            if (ImGui::Checkbox("Selected device is a member", &is_member))
+            {
+                m_app->toggle_group_member(m_selected_group);
+            }
+            ImGui::Text("%zu members", group.members.size());
+            if (ImGui::Button("Delete group"))
+            {
+                std::cout << "[Info] Deleting group '" << group.name << "'." << std::endl;
+                m_app->delete_group(m_selected_group);
+                m_selected_group = 0;
+            }
+        }
+
+        if (m_app->m_last_fan_out)
+        {
+            const FanOutTracker& fan_out = *m_app->m_last_fan_out;
+            if (fan_out.is_complete())
+            {
+                ImGui::Text("Last group update: %zu writes acknowledged, skew %.1f ms", fan_out.acknowledged(),
+                    std::chrono::duration<double, std::milli>(fan_out.skew()).count());
+            }
+            else
+            {
+                ImGui::Text("Last group update: %zu writes acknowledged so far", fan_out.acknowledged());
+            }
+        }
+
     }
     ImGui::End(); // Bluetooth Connect
 
@@ -141,6 +216,14 @@ void LightTab::render()
         {
             m_app->update_controller_led_config(m_selected_led_config + 1);
         }
+        if (!m_app->m_groups.empty())
+        {
+            const std::string label = "Apply to group \'" + m_app->m_groups[m_selected_group].name + "\'";
+            if (ImGui::Button(label.c_str()))
+            {
+                m_app->apply_led_config_to_group(m_selected_group);
+            }
+        }
 
         // New config
         ImGui::Text("New led config");
@@ -197,6 +280,12 @@ void LightTab::render()
         {
             m_app->led_controller()->update_rgb();
         }
+        int curve = static_cast<int>(m_app->led_controller()->led_config()->curve);
+        if (ImGui::Combo("Brightness curve", &curve, color_pipeline::curve_strings, IM_ARRAYSIZE(color_pipeline::curve_strings)))
+        {
+            m_app->led_controller()->led_config()->curve = static_cast<ColorCurve>(curve);
+            m_app->led_controller()->update_rgb();
+        }
         ImGui::Text("Mode selection");
         if (ImGui::Combo("Mode", &m_app->led_controller()->led_config()->mode.index, m_app->led_controller()->led_config()->mode.mode_strings, IM_ARRAYSIZE(m_app->led_controller()->led_config()->mode.mode_strings)))
         {
@@ -206,12 +295,37 @@ void LightTab::render()
         {
             m_app->led_controller()->update_mode();
         }
+        ImGui::Text("Animation");
+        std::vector<const char*> animation_items = { "None" };
+        for (const std::shared_ptr<const Animation>& animation : m_app->m_animations)
+        {
+            animation_items.push_back(animation->name.c_str());
+        }
+        const auto playing = std::ranges::find(m_app->m_animations, m_app->led_controller()->animation());
+        int selected_animation = playing == m_app->m_animations.end() ? 0 : static_cast<int>(std::distance(m_app->m_animations.begin(), playing)) + 1;
+        if (ImGui::Combo("Animation", &selected_animation, animation_items.data(), static_cast<int>(animation_items.size())))
+        {
+            if (selected_animation == 0)
+            {
+                std::cout << "[Info] Stopping animation on controller \'" << m_app->led_controller()->m_name << "\'." << std::endl;
+                m_app->led_controller()->stop_animation();
+            }
+            else
+            {
+                std::cout << "[Info] Playing animation \'" << animation_items[selected_animation] << "\' on controller \'" << m_app->led_controller()->m_name << "\'." << std::endl;
+                m_app->led_controller()->play_animation(m_app->m_animations[selected_animation - 1]);
+            }
+        }
     }
     ImGui::End(); // Light Settings
 
     if (ImGui::Begin("Timers"))
     {
-        ImGui::Checkbox("Timer enabled", &m_app->led_controller()->m_timer_enabled);
+        if (ImGui::Checkbox("Timer enabled", &m_app->led_controller()->m_timer_enabled))
+        {
+            m_app->mark_controller_changed(m_app->led_controller());
+            m_app->m_timer.reschedule();
+        }
         if (m_app->led_controller()->m_timer_enabled)
         {
             // Available configs
@@ -270,34 +384,104 @@ void LightTab::render()
 
             // Timer settings
             ImGui::Text("Timer selection");
-            ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.25f);
-            if (ImGui::InputFloat("Start time", &m_app->led_controller()->timer_config()->start))
+            TimerConfiguration* timer_config = m_app->led_controller()->timer_config();
+            int anchor = static_cast<int>(timer_config->anchor);
+            if (ImGui::Combo("Schedule type", &anchor, TimerConfiguration::anchor_strings, IM_ARRAYSIZE(TimerConfiguration::anchor_strings)))
             {
-                if (m_app->led_controller()->timer_config()->start < 0)
-                {
-                    std::cout << "[Info] Start time must be non-negative" << std::endl;
-                    m_app->led_controller()->timer_config()->start = 0.0f;
-                }
+                timer_config->anchor = static_cast<TimerAnchor>(anchor);
+                m_app->mark_timer_config_changed(timer_config);
+                m_app->m_timer.reschedule();
             }
-            ImGui::SameLine();
-            if (ImGui::InputFloat("End time", &m_app->led_controller()->timer_config()->end))
+
+            if (timer_config->anchor == TimerAnchor::WALL_CLOCK)
             {
-                if (m_app->led_controller()->timer_config()->end <= 0)
+                WallClockRule& rule = timer_config->wall_clock;
+                bool rule_changed = false;
+                ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.25f);
+                int on_reference = static_cast<int>(rule.on.reference);
+                if (ImGui::Combo("On at", &on_reference, TimeOfDay::reference_strings, IM_ARRAYSIZE(TimeOfDay::reference_strings)))
+                {
+                    rule.on.reference = static_cast<TimeReference>(on_reference);
+                    rule_changed = true;
+                }
+                ImGui::SameLine();
+                rule_changed |= ImGui::InputInt("On offset (min)", &rule.on.offset_minutes);
+                int off_reference = static_cast<int>(rule.off.reference);
+                if (ImGui::Combo("Off at", &off_reference, TimeOfDay::reference_strings, IM_ARRAYSIZE(TimeOfDay::reference_strings)))
+                {
+                    rule.off.reference = static_cast<TimeReference>(off_reference);
+                    rule_changed = true;
+                }
+                ImGui::SameLine();
+                rule_changed |= ImGui::InputInt("Off offset (min)", &rule.off.offset_minutes);
+                ImGui::PopItemWidth();
+                rule.on.offset_minutes = std::clamp(rule.on.offset_minutes, -24 * 60, 24 * 60);
+                rule.off.offset_minutes = std::clamp(rule.off.offset_minutes, -24 * 60, 24 * 60);
+
+                for (int day = 0; day < 7; day++)
+                {
+                    unsigned int weekdays = rule.weekdays;
+                    if (day > 0) ImGui::SameLine();
+                    if (ImGui::CheckboxFlags(WallClockRule::weekday_strings[day], &weekdays, 1u << day))
+                    {
+                        rule.weekdays = static_cast<uint8_t>(weekdays);
+                        rule_changed = true;
+                    }
+                }
+
+                if (rule_changed)
                 {
-                    std::cout << "[Info] End time must be positive" << std::endl;
-                    m_app->led_controller()->timer_config()->end = 1.0f;
+                    m_app->mark_timer_config_changed(timer_config);
+                    m_app->m_timer.reschedule();
+                }
+
+                if (std::optional<wall_clock::time_point> next = wall_clock::next_transition(rule, std::chrono::system_clock::now()))
+                {
+                    const std::chrono::zoned_time local(std::chrono::current_zone(), std::chrono::floor<std::chrono::minutes>(*next));
+                    ImGui::Text("Next switch: %s", std::format("{:%a %H:%M}", local).c_str());
                 }
             }
-            ImGui::PopItemWidth();
-            if (ImGui::InputInt("Repeat number", &m_app->led_controller()->timer_config()->repeat))
+            else
             {
-                if (m_app->led_controller()->timer_config()->repeat < 1)
+                ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.25f);
+                if (ImGui::InputFloat("Start time", &m_app->led_controller()->timer_config()->start))
                 {
-                    std::cout << "[Info] Repeat number must be non-negative" << std::endl;
-                    m_app->led_controller()->timer_config()->repeat = 1;
+                    if (m_app->led_controller()->timer_config()->start < 0)
+                    {
+                        std::cout << "[Info] Start time must be non-negative" << std::endl;
+                        m_app->led_controller()->timer_config()->start = 0.0f;
+                    }
+                    m_app->mark_timer_config_changed(m_app->led_controller()->timer_config());
+                    m_app->m_timer.reschedule();
+                }
+                ImGui::SameLine();
+                if (ImGui::InputFloat("End time", &m_app->led_controller()->timer_config()->end))
+                {
+                    if (m_app->led_controller()->timer_config()->end <= 0)
+                    {
+                        std::cout << "[Info] End time must be positive" << std::endl;
+                        m_app->led_controller()->timer_config()->end = 1.0f;
+                    }
+                    m_app->mark_timer_config_changed(m_app->led_controller()->timer_config());
+                    m_app->m_timer.reschedule();
+                }
+                ImGui::PopItemWidth();
+                if (ImGui::InputInt("Repeat number", &m_app->led_controller()->timer_config()->repeat))
+                {
+                    if (m_app->led_controller()->timer_config()->repeat < 1)
+                    {
+                        std::cout << "[Info] Repeat number must be non-negative" << std::endl;
+                        m_app->led_controller()->timer_config()->repeat = 1;
+                    }
+                    m_app->mark_timer_config_changed(m_app->led_controller()->timer_config());
+                    m_app->m_timer.reschedule();
                 }
             }
-            ImGui::Checkbox("Inverse", &m_app->led_controller()->timer_config()->inverse);
+            if (ImGui::Checkbox("Inverse", &m_app->led_controller()->timer_config()->inverse))
+            {
+                m_app->mark_timer_config_changed(m_app->led_controller()->timer_config());
+                m_app->m_timer.reschedule();
+            }
         }
     }
     ImGui::End(); // Timers
@@ -306,8 +490,6 @@ void LightTab::render()
     {
         // Global timer
         ImGui::Text("Global timer");
-        m_app->m_timer.update();
-        std::cout << "[Debug] Relative time: " << std::to_string(m_app->m_timer.get_relative_time()) << std::endl;
 
         ImGui::SameLine();
         if (ImGui::Button(!m_app->m_timer.is_active() ? "Start" : (!m_app->m_timer.is_paused() ? "Pause" : "Unpause")))
@@ -325,49 +507,47 @@ void LightTab::render()
 
 
         // Live timer view plot
-        const double x_max = std::ranges::max(
-            m_app->m_timer_configs | std::views::transform([](const std::unique_ptr<TimerConfiguration>& timer_config)
-                { return timer_config->end * timer_config->repeat; }
-            )
-        );
+        // The axis only depends on the configurations, recomputed when one of them was added, removed or edited
+        auto is_relative = [](const TimerConfiguration& timer_config) { return timer_config.anchor == TimerAnchor::RELATIVE; };
+        const std::pair<uint64_t, size_t> plot_key = { TimerConfiguration::last_version(), m_app->m_timer_configs.size() };
+        if (plot_key != m_plot_key)
+        {
+            m_plot_x_max.reset();
+            for (const TimerConfiguration& timer_config : m_app->m_timer_configs.values() | std::views::filter(is_relative))
+            {
+                m_plot_x_max = std::max(m_plot_x_max.value_or(0.0), static_cast<double>(timer_config.end) * timer_config.repeat);
+            }
+            m_plot_key = plot_key;
+        }
+        const double x_max = m_plot_x_max.value_or(1.0);
         const double y_min = -0.1; const double y_max = 1.2;
         ImPlot::SetNextAxesLimits(0.0, x_max, y_min, y_max, ImGuiCond_Always);
         double y_ticks[2] = { 0.0, 1.0 };
 
-        if (ImPlot::BeginPlot("Timer View", ImVec2(-1, 0), ImPlotFlags_NoInputs | ImPlotFlags_Equal))
+        if (!m_plot_x_max)
+        {
+            ImGui::Text("Only wall clock schedules, nothing to show on the relative time axis.");
+        }
+        else if (ImPlot::BeginPlot("Timer View", ImVec2(-1, 0), ImPlotFlags_NoInputs | ImPlotFlags_Equal))
         {
             ImPlot::PushStyleVar(ImPlotStyleVar_LineWeight, 2.0f);
             ImPlot::SetupAxisTicks(ImAxis_Y1, y_ticks, 2);
 
             // Plot timers
-            std::vector<double> x_timer;
-            std::vector<double> y_timer;
             for (size_t i = 1; i < m_app->m_timer_configs.size(); i++)
             {
-                const int num_elements = 2 + 4 * m_app->m_timer_configs[i]->repeat;
-                x_timer.resize(num_elements);
-                y_timer.resize(num_elements);
-
-                x_timer[0] = 0;
-                y_timer[0] = static_cast<double>(m_app->m_timer_configs[i]->inverse);
-
-                for (size_t j = 0; j < m_app->m_timer_configs[i]->repeat; j++)
+                if (!is_relative(m_app->m_timer_configs[i]))
                 {
-                    x_timer[1 + 4 * j] = m_app->m_timer_configs[i]->start + j * m_app->m_timer_configs[i]->end;
-                    x_timer[2 + 4 * j] = m_app->m_timer_configs[i]->start + j * m_app->m_timer_configs[i]->end;
-                    x_timer[3 + 4 * j] = m_app->m_timer_configs[i]->end + j * m_app->m_timer_configs[i]->end;
-                    x_timer[4 + 4 * j] = m_app->m_timer_configs[i]->end + j * m_app->m_timer_configs[i]->end;
-
-                    y_timer[1 + 4 * j] = static_cast<double>(m_app->m_timer_configs[i]->inverse);
-                    y_timer[2 + 4 * j] = static_cast<double>(!m_app->m_timer_configs[i]->inverse);
-                    y_timer[3 + 4 * j] = static_cast<double>(!m_app->m_timer_configs[i]->inverse);
-                    y_timer[4 + 4 * j] = static_cast<double>(m_app->m_timer_configs[i]->inverse);
+                    continue; // Wall clock schedules have no place on the relative time axis
                 }
 
-                x_timer[num_elements - 1] = x_max;
-                y_timer[num_elements - 1] = 0.0;
-
-                ImPlot::PlotLine(m_app->m_timer_configs[i]->name.c_str(), x_timer.data(), y_timer.data(), num_elements);
+                const TimerPlot& plot = m_app->m_timer_configs[i].plot(x_max);
+                const char* label = m_app->m_timer_configs[i].name.c_str();
+                if (!plot.envelope_x.empty())
+                {
+                    ImPlot::PlotShaded(label, plot.envelope_x.data(), plot.envelope_low.data(), plot.envelope_high.data(), static_cast<int>(plot.envelope_x.size()));
+                }
+                ImPlot::PlotLine(label, plot.x.data(), plot.y.data(), static_cast<int>(plot.x.size()));
             }
 
             // Plot vertical line that follows relative time
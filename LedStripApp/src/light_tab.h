@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string>
+#include <utility>
+#include <optional>
+#include <cstdint>
 
 #include "app_tab.h"
 
@@ -20,6 +23,9 @@ private:
     char m_new_controller_name[100] = "\0";
     char m_rename_controller_name[100] = "\0";
 
+    int m_selected_group = 0;
+    char m_new_group_name[100] = "\0";
+
     int m_selected_led_config = 0;
     char m_new_led_config_name[100] = "\0";
     char m_rename_led_config_name[100] = "\0";
@@ -27,4 +33,8 @@ private:
     int m_selected_timer_config = 0;
     char m_new_timer_config_name[100] = "\0";
     char m_rename_timer_config_name[100] = "\0";
+
+    // Live timer view axis, keyed by the newest configuration version and the number of configurations
+    std::pair<uint64_t, size_t> m_plot_key = { 0, 0 };
+    std::optional<double> m_plot_x_max; // Empty when no configuration is relative
 };
\ No newline at end of file
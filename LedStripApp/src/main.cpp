@@ -4,7 +4,7 @@
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow)
 {
     App app = App();
-    if (!app.init())
+    if (!app.init(pCmdLine ? pCmdLine : L""))
     {
         std::cout << "[Fatal] Failed to create the app." << std::endl;
         return EXIT_FAILURE;
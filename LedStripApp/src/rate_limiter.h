@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <algorithm>
+
+// Token bucket limiting how many commands per second are sent to a device.
+// Not thread safe, owned by whoever sends the commands.
+class RateLimiter
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	explicit RateLimiter(float rate_hz, float burst)
+		: m_rate_hz(rate_hz), m_burst(burst), m_tokens(burst), m_last_refill(clock::now()) {}
+	~RateLimiter() = default;
+
+	inline void set_rate(float rate_hz) { refill(); m_rate_hz = std::max(rate_hz, 0.1f); }
+	inline float get_rate() const { return m_rate_hz; }
+
+	inline bool try_acquire()
+	{
+		refill();
+		if (m_tokens < 1.0f)
+		{
+			return false;
+		}
+		m_tokens -= 1.0f;
+		return true;
+	}
+
+	inline clock::duration time_until_available()
+	{
+		refill();
+		const float missing_tokens = std::max(1.0f - m_tokens, 0.0f);
+		return std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(missing_tokens / m_rate_hz));
+	}
+
+private:
+	inline void refill()
+	{
+		const clock::time_point now = clock::now();
+		const float elapsed_s = std::chrono::duration<float>(now - m_last_refill).count();
+		m_tokens = std::min(m_burst, m_tokens + elapsed_s * m_rate_hz);
+		m_last_refill = now;
+	}
+
+private:
+	float m_rate_hz;
+	float m_burst;
+	float m_tokens;
+	clock::time_point m_last_refill;
+};
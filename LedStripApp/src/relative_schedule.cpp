@@ -0,0 +1,36 @@
+#include <cmath>
+
+#include "relative_schedule.h"
+
+namespace relative_clock
+{
+    nanoseconds to_nanoseconds(float seconds)
+    {
+        return nanoseconds(std::llround(static_cast<double>(seconds) * 1e9));
+    }
+
+    bool is_active(const RelativeRule& rule, nanoseconds time)
+    {
+        return time < duration(rule) && time % rule.period >= rule.start;
+    }
+
+    std::optional<nanoseconds> next_transition(const RelativeRule& rule, nanoseconds after)
+    {
+        const nanoseconds total = duration(rule);
+        if (after >= total)
+        {
+            return std::nullopt;
+        }
+        if (rule.start <= nanoseconds(0))
+        {
+            return total; // Active for the whole run, cycle boundaries are not edges
+        }
+
+        const nanoseconds cycle_start = after - after % rule.period;
+        if (after < cycle_start + rule.start)
+        {
+            return cycle_start + rule.start;
+        }
+        return cycle_start + rule.period;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+// Cycles counted from the moment the global timer started, in integer nanoseconds. Edges are computed
+// from their cycle index with integer arithmetic, so they do not drift however long the timer runs.
+struct RelativeRule
+{
+	std::chrono::nanoseconds start{ 0 }; // Within each cycle
+	std::chrono::nanoseconds period{ 0 }; // Cycle length, the configuration's end
+	int repeat = 1;
+
+	bool operator==(const RelativeRule& other) const = default;
+};
+
+namespace relative_clock
+{
+	using nanoseconds = std::chrono::nanoseconds;
+
+	nanoseconds to_nanoseconds(float seconds);
+	// Active during [cycle start + start, cycle end) of each of the first `repeat` cycles
+	bool is_active(const RelativeRule& rule, nanoseconds time);
+	// First time after `after` at which is_active changes, none once the last cycle ended
+	std::optional<nanoseconds> next_transition(const RelativeRule& rule, nanoseconds after);
+	inline nanoseconds duration(const RelativeRule& rule) { return rule.period * rule.repeat; }
+}
@@ -0,0 +1,262 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+
+#include "settings_binary.h"
+#include "durable_file.h"
+
+using namespace settings_binary;
+
+namespace
+{
+    // Collects the string table while the records are built
+    class StringTable
+    {
+    public:
+        StringRef add(const std::string& text)
+        {
+            const StringRef ref = { static_cast<uint32_t>(m_data.size()), static_cast<uint32_t>(text.size()) };
+            m_data += text;
+            return ref;
+        }
+
+        inline const std::string& data() const { return m_data; }
+
+    private:
+        std::string m_data;
+    };
+
+    template <typename T>
+    void append(std::string& out, const std::vector<T>& records)
+    {
+        out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+    }
+}
+
+namespace settings_binary
+{
+    std::string encode(const SettingsSnapshot& snapshot)
+    {
+        StringTable strings;
+
+        std::vector<ControllerRecord> controllers;
+        controllers.reserve(snapshot.controllers.size());
+        for (const ControllerSettings& settings : snapshot.controllers)
+        {
+            ControllerRecord record = {};
+            record.name = strings.add(settings.name);
+            record.selected_led_config = settings.selected_led_config;
+            record.selected_timer_config = settings.selected_timer_config;
+            record.max_command_rate = settings.max_command_rate;
+            record.timer_enabled = settings.timer_enabled;
+            record.streaming_enabled = settings.streaming_enabled;
+            record.dithering_enabled = settings.dithering_enabled;
+            controllers.push_back(record);
+        }
+
+        std::vector<LEDConfigRecord> led_configs;
+        led_configs.reserve(snapshot.led_configs.size());
+        for (const LEDConfiguration& config : snapshot.led_configs)
+        {
+            LEDConfigRecord record = {};
+            record.name = strings.add(config.name);
+            std::copy(config.color.begin(), config.color.end(), record.color);
+            record.brightness = config.brightness;
+            record.mode_index = config.mode.index;
+            record.mode_speed = config.mode.speed;
+            record.device_on = config.device_on;
+            record.curve = static_cast<uint8_t>(config.curve);
+            led_configs.push_back(record);
+        }
+
+        std::vector<TimerConfigRecord> timer_configs;
+        timer_configs.reserve(snapshot.timer_configs.size());
+        for (const TimerSettings& settings : snapshot.timer_configs)
+        {
+            TimerConfigRecord record = {};
+            record.name = strings.add(settings.name);
+            record.start = settings.start;
+            record.end = settings.end;
+            record.repeat = settings.repeat;
+            record.on_offset = settings.wall_clock.on.offset_minutes;
+            record.off_offset = settings.wall_clock.off.offset_minutes;
+            record.inverse = settings.inverse;
+            record.anchor = static_cast<uint8_t>(settings.anchor);
+            record.on_reference = static_cast<uint8_t>(settings.wall_clock.on.reference);
+            record.off_reference = static_cast<uint8_t>(settings.wall_clock.off.reference);
+            record.weekdays = settings.wall_clock.weekdays;
+            timer_configs.push_back(record);
+        }
+
+        std::vector<GroupRecord> groups;
+        std::vector<StringRef> members;
+        groups.reserve(snapshot.groups.size());
+        for (const ControllerGroup& group : snapshot.groups)
+        {
+            groups.push_back({ strings.add(group.name), static_cast<uint32_t>(members.size()), static_cast<uint32_t>(group.members.size()) });
+            for (const std::string& member : group.members)
+            {
+                members.push_back(strings.add(member));
+            }
+        }
+
+        std::string payload;
+        append(payload, controllers);
+        append(payload, led_configs);
+        append(payload, timer_configs);
+        append(payload, groups);
+        append(payload, members);
+        payload += strings.data();
+
+        Header header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.header_size = sizeof(Header);
+        header.journal_epoch = snapshot.journal_epoch;
+        header.controller_count = static_cast<uint32_t>(controllers.size());
+        header.led_config_count = static_cast<uint32_t>(led_configs.size());
+        header.timer_config_count = static_cast<uint32_t>(timer_configs.size());
+        header.group_count = static_cast<uint32_t>(groups.size());
+        header.member_count = static_cast<uint32_t>(members.size());
+        header.string_table_size = static_cast<uint32_t>(strings.data().size());
+        header.checksum = durable_file::checksum(payload.data(), payload.size());
+
+        std::string image(reinterpret_cast<const char*>(&header), sizeof(header));
+        image += payload;
+        return image;
+    }
+}
+
+std::optional<SettingsImage> SettingsImage::read(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    SettingsImage image;
+    image.m_size = static_cast<size_t>(file.tellg());
+    image.m_data.resize((image.m_size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    file.seekg(0);
+    if (image.m_size < sizeof(Header) || !file.read(reinterpret_cast<char*>(image.m_data.data()), image.m_size))
+    {
+        std::cout << "[Warning] settings.bin is cut off, falling back to settings.yaml." << std::endl;
+        return std::nullopt;
+    }
+
+    const Header& header = image.header();
+    if (header.magic != MAGIC || header.version != VERSION || header.header_size != sizeof(Header))
+    {
+        std::cout << "[Info] settings.bin is from another version, importing settings.yaml." << std::endl;
+        return std::nullopt;
+    }
+
+    image.m_controllers = sizeof(Header);
+    image.m_led_configs = image.m_controllers + size_t(header.controller_count) * sizeof(ControllerRecord);
+    image.m_timer_configs = image.m_led_configs + size_t(header.led_config_count) * sizeof(LEDConfigRecord);
+    image.m_groups = image.m_timer_configs + size_t(header.timer_config_count) * sizeof(TimerConfigRecord);
+    image.m_members = image.m_groups + size_t(header.group_count) * sizeof(GroupRecord);
+    image.m_strings = image.m_members + size_t(header.member_count) * sizeof(StringRef);
+    if (image.m_strings + header.string_table_size != image.m_size
+        || durable_file::checksum(image.bytes() + sizeof(Header), image.m_size - sizeof(Header)) != header.checksum)
+    {
+        std::cout << "[Warning] settings.bin is corrupt, falling back to settings.yaml." << std::endl;
+        return std::nullopt;
+    }
+    return image;
+}
+
+std::span<const ControllerRecord> SettingsImage::controllers() const
+{
+    return records<ControllerRecord>(m_controllers, header().controller_count);
+}
+
+std::span<const LEDConfigRecord> SettingsImage::led_configs() const
+{
+    return records<LEDConfigRecord>(m_led_configs, header().led_config_count);
+}
+
+std::span<const TimerConfigRecord> SettingsImage::timer_configs() const
+{
+    return records<TimerConfigRecord>(m_timer_configs, header().timer_config_count);
+}
+
+std::span<const GroupRecord> SettingsImage::groups() const
+{
+    return records<GroupRecord>(m_groups, header().group_count);
+}
+
+std::span<const StringRef> SettingsImage::members(const GroupRecord& group) const
+{
+    if (size_t(group.first_member) + group.member_count > header().member_count)
+    {
+        return {};
+    }
+    return records<StringRef>(m_members, header().member_count).subspan(group.first_member, group.member_count);
+}
+
+std::string_view SettingsImage::string(StringRef ref) const
+{
+    if (size_t(ref.offset) + ref.size > header().string_table_size)
+    {
+        return {};
+    }
+    return { bytes() + m_strings + ref.offset, ref.size };
+}
+
+SettingsSnapshot SettingsImage::snapshot() const
+{
+    SettingsSnapshot snapshot;
+    snapshot.journal_epoch = journal_epoch();
+
+    snapshot.controllers.reserve(controllers().size());
+    for (const ControllerRecord& record : controllers())
+    {
+        snapshot.controllers.push_back({
+            std::string(string(record.name)),
+            record.selected_led_config,
+            record.selected_timer_config,
+            record.timer_enabled != 0,
+            record.streaming_enabled != 0,
+            record.max_command_rate,
+            record.dithering_enabled != 0
+        });
+    }
+
+    snapshot.led_configs.reserve(led_configs().size());
+    for (const LEDConfigRecord& record : led_configs())
+    {
+        LEDConfiguration& config = snapshot.led_configs.emplace_back(std::string(string(record.name)), record.device_on != 0,
+            std::array<float, 3>{ record.color[0], record.color[1], record.color[2] }, record.brightness, Mode(record.mode_index, record.mode_speed));
+        config.curve = static_cast<ColorCurve>(std::min<int>(record.curve, static_cast<int>(std::size(color_pipeline::curve_strings)) - 1));
+    }
+
+    snapshot.timer_configs.reserve(timer_configs().size());
+    for (const TimerConfigRecord& record : timer_configs())
+    {
+        TimerSettings& settings = snapshot.timer_configs.emplace_back();
+        settings.name = string(record.name);
+        settings.start = record.start;
+        settings.end = record.end;
+        settings.repeat = record.repeat;
+        settings.inverse = record.inverse != 0;
+        settings.anchor = static_cast<TimerAnchor>(record.anchor);
+        settings.wall_clock.on = { static_cast<TimeReference>(record.on_reference), record.on_offset };
+        settings.wall_clock.off = { static_cast<TimeReference>(record.off_reference), record.off_offset };
+        settings.wall_clock.weekdays = record.weekdays;
+    }
+
+    snapshot.groups.reserve(groups().size());
+    for (const GroupRecord& record : groups())
+    {
+        ControllerGroup& group = snapshot.groups.emplace_back();
+        group.name = string(record.name);
+        for (const StringRef& member : members(record))
+        {
+            group.members.emplace_back(string(member));
+        }
+    }
+    return snapshot;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <span>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+
+#include "settings_snapshot.h"
+
+// Versioned binary form of a settings snapshot, settings.bin. A header is followed by arrays of
+// fixed-width records and a string table the records point into, all 4-byte aligned, so the file
+// is loaded with a single read and used in place without parsing. settings.yaml stays the form
+// settings are imported from and exported to.
+//
+// Layout: Header | ControllerRecord[] | LEDConfigRecord[] | TimerConfigRecord[] | GroupRecord[] |
+//         StringRef[] (group members) | string table
+namespace settings_binary
+{
+	constexpr uint32_t MAGIC = 0x42534C4C; // "LLSB" on disk
+	constexpr uint16_t VERSION = 1; // Bump on any record change, older files are then imported from settings.yaml
+
+	struct StringRef
+	{
+		uint32_t offset; // Into the string table
+		uint32_t size;
+	};
+
+	struct Header
+	{
+		uint32_t magic;
+		uint16_t version;
+		uint16_t header_size;
+		uint64_t journal_epoch;
+		uint32_t controller_count;
+		uint32_t led_config_count;
+		uint32_t timer_config_count;
+		uint32_t group_count;
+		uint32_t member_count;
+		uint32_t string_table_size;
+		uint32_t checksum; // Of everything after the header
+		uint32_t reserved;
+	};
+
+	struct ControllerRecord
+	{
+		StringRef name;
+		int32_t selected_led_config;
+		int32_t selected_timer_config;
+		float max_command_rate;
+		uint8_t timer_enabled;
+		uint8_t streaming_enabled;
+		uint8_t dithering_enabled;
+		uint8_t reserved;
+	};
+
+	struct LEDConfigRecord
+	{
+		StringRef name;
+		float color[3];
+		float brightness;
+		int32_t mode_index;
+		float mode_speed;
+		uint8_t device_on;
+		uint8_t curve;
+		uint8_t reserved[2];
+	};
+
+	struct TimerConfigRecord
+	{
+		StringRef name;
+		float start;
+		float end;
+		int32_t repeat;
+		int32_t on_offset;
+		int32_t off_offset;
+		uint8_t inverse;
+		uint8_t anchor;
+		uint8_t on_reference;
+		uint8_t off_reference;
+		uint8_t weekdays;
+		uint8_t reserved[3];
+	};
+
+	struct GroupRecord
+	{
+		StringRef name;
+		uint32_t first_member; // Into the member array
+		uint32_t member_count;
+	};
+
+	static_assert(std::endian::native == std::endian::little, "settings.bin is little endian");
+	static_assert(sizeof(Header) == 48 && sizeof(ControllerRecord) == 24 && sizeof(LEDConfigRecord) == 36
+		&& sizeof(TimerConfigRecord) == 36 && sizeof(GroupRecord) == 16, "Record layout is part of the file format");
+	static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<ControllerRecord>
+		&& std::is_trivially_copyable_v<LEDConfigRecord> && std::is_trivially_copyable_v<TimerConfigRecord>
+		&& std::is_trivially_copyable_v<GroupRecord>);
+
+	std::string encode(const SettingsSnapshot& snapshot);
+}
+
+// A settings.bin file read into a single buffer. Records are used in place and names stay views
+// into the buffer until snapshot() copies them into the configurations.
+class SettingsImage
+{
+public:
+	static std::optional<SettingsImage> read(const std::filesystem::path& path); // Empty if missing, torn or of another version
+
+	inline uint64_t journal_epoch() const { return header().journal_epoch; }
+	std::span<const settings_binary::ControllerRecord> controllers() const;
+	std::span<const settings_binary::LEDConfigRecord> led_configs() const;
+	std::span<const settings_binary::TimerConfigRecord> timer_configs() const;
+	std::span<const settings_binary::GroupRecord> groups() const;
+	std::span<const settings_binary::StringRef> members(const settings_binary::GroupRecord& group) const;
+	std::string_view string(settings_binary::StringRef ref) const; // Empty if out of range
+
+	SettingsSnapshot snapshot() const;
+
+private:
+	SettingsImage() = default;
+
+	inline const settings_binary::Header& header() const { return *reinterpret_cast<const settings_binary::Header*>(m_data.data()); }
+	inline const char* bytes() const { return reinterpret_cast<const char*>(m_data.data()); }
+	template <typename T>
+	std::span<const T> records(size_t offset, size_t count) const { return { reinterpret_cast<const T*>(bytes() + offset), count }; }
+
+private:
+	std::vector<uint64_t> m_data; // 8-byte words keep every record aligned
+	size_t m_size = 0;
+
+	// Byte offsets of the sections
+	size_t m_controllers = 0;
+	size_t m_led_configs = 0;
+	size_t m_timer_configs = 0;
+	size_t m_groups = 0;
+	size_t m_members = 0;
+	size_t m_strings = 0;
+};
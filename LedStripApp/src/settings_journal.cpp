@@ -0,0 +1,276 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+#include "settings_journal.h"
+#include "settings_snapshot.h"
+#include "durable_file.h"
+#include "yaml-cpp/yaml.h"
+
+namespace
+{
+    uint32_t checksum(const std::string& text)
+    {
+        return durable_file::checksum(text.data(), text.size());
+    }
+}
+
+SettingsJournal::~SettingsJournal()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    if (m_writer.joinable())
+    {
+        m_writer.join();
+    }
+    if (m_file)
+    {
+        std::fclose(m_file);
+    }
+    if (m_next_file)
+    {
+        std::fclose(m_next_file);
+    }
+}
+
+size_t SettingsJournal::replay(const std::filesystem::path& directory, uint64_t epoch, SettingsSnapshot& settings, uint64_t& newest_epoch)
+{
+    size_t applied = 0;
+    newest_epoch = epoch;
+    for (const auto& [file_epoch, path] : journal_files(directory))
+    {
+        if (file_epoch == epoch)
+        {
+            applied += replay_file(path, settings);
+        }
+        else if (file_epoch > epoch)
+        {
+            std::cout << "[Warning] Skipping settings journal " << file_epoch << ", its snapshot was never saved." << std::endl;
+        }
+        newest_epoch = std::max(newest_epoch, file_epoch);
+    }
+    return applied;
+}
+
+void SettingsJournal::remove_before(const std::filesystem::path& directory, uint64_t epoch)
+{
+    for (const auto& [file_epoch, path] : journal_files(directory))
+    {
+        std::error_code error;
+        if (file_epoch < epoch && !std::filesystem::remove(path, error))
+        {
+            std::cout << "[Warning] Failed to remove old settings journal: " << error.message() << std::endl;
+        }
+    }
+}
+
+std::filesystem::path SettingsJournal::file_path(const std::filesystem::path& directory, uint64_t epoch)
+{
+    return directory / ("settings." + std::to_string(epoch) + ".journal");
+}
+
+std::vector<std::pair<uint64_t, std::filesystem::path>> SettingsJournal::journal_files(const std::filesystem::path& directory)
+{
+    std::vector<std::pair<uint64_t, std::filesystem::path>> files;
+    std::error_code error;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        // settings.<epoch>.journal
+        const std::string name = entry.path().filename().string();
+        if (name.starts_with("settings.") && name.ends_with(".journal") && name.size() > 17)
+        {
+            const std::string digits = name.substr(9, name.size() - 17);
+            if (std::ranges::all_of(digits, [](char c) { return c >= '0' && c <= '9'; }))
+            {
+                files.push_back({ std::stoull(digits), entry.path() });
+            }
+        }
+    }
+    std::ranges::sort(files);
+    return files;
+}
+
+size_t SettingsJournal::replay_file(const std::filesystem::path& path, SettingsSnapshot& settings)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return 0;
+    }
+
+    size_t applied = 0;
+    std::streamoff intact = 0; // Bytes up to the end of the last whole record
+    std::string line;
+    while (std::getline(file, line))
+    {
+        // <checksum> <section> <index> <entry>
+        const size_t split = line.find(' ');
+        char* end = nullptr;
+        const unsigned long stored = std::strtoul(line.c_str(), &end, 16);
+        if (file.eof() || split != 8 || end != line.c_str() + split || stored != checksum(line.substr(split + 1)))
+        {
+            std::cout << "[Warning] Settings journal is cut off after " << applied << " records, ignoring the rest." << std::endl;
+            file.close();
+            std::error_code error;
+            std::filesystem::resize_file(path, intact, error);
+            break;
+        }
+        intact += line.size() + 1;
+
+        std::istringstream record(line.substr(split + 1));
+        std::string section;
+        int index = -1;
+        record >> section >> index;
+        std::string entry;
+        std::getline(record >> std::ws, entry);
+        try
+        {
+            if (!settings_yaml::apply(settings, section, index, YAML::Load(entry)))
+            {
+                std::cout << "[Warning] Skipping settings journal record for a missing " << section << " entry." << std::endl;
+                continue;
+            }
+        }
+        catch (const YAML::Exception& ex)
+        {
+            std::cout << "[Warning] Skipping unreadable settings journal record: " << ex.what() << std::endl;
+            continue;
+        }
+        applied++;
+    }
+    return applied;
+}
+
+void SettingsJournal::open(const std::filesystem::path& directory, uint64_t epoch)
+{
+    flush(); // Records of the previous epoch belong in its file
+    {
+        std::lock_guard<std::mutex> lock(m_file_mutex);
+        if (m_file)
+        {
+            std::fclose(m_file);
+        }
+        m_file = durable_file::open(file_path(directory, epoch), false);
+        if (!m_file)
+        {
+            std::cout << "[Error] Failed to open settings journal." << std::endl;
+        }
+    }
+    m_directory = directory;
+    m_record_count = 0;
+    if (!m_writer.joinable())
+    {
+        m_writer = std::thread(&SettingsJournal::writer_loop, this);
+    }
+}
+
+void SettingsJournal::begin_epoch(uint64_t epoch)
+{
+    flush(); // Records so far are part of the snapshot and stay out of the new file
+    {
+        std::lock_guard<std::mutex> lock(m_file_mutex);
+        if (m_next_file)
+        {
+            std::fclose(m_next_file);
+        }
+        // A file of this epoch can only be left from a snapshot that never reached the disk
+        m_next_file = durable_file::open(file_path(m_directory, epoch), true);
+        if (!m_next_file)
+        {
+            std::cout << "[Error] Failed to open settings journal." << std::endl;
+        }
+    }
+    m_next_epoch = epoch;
+    m_record_count = 0;
+}
+
+void SettingsJournal::end_epoch()
+{
+    if (!m_next_epoch)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_file_mutex);
+        if (m_file)
+        {
+            std::fclose(m_file);
+        }
+        m_file = m_next_file;
+        m_next_file = nullptr;
+    }
+    remove_before(m_directory, *m_next_epoch);
+    m_next_epoch.reset();
+}
+
+void SettingsJournal::append(const std::string& section, int index, const std::string& entry)
+{
+    if (!m_writer.joinable())
+    {
+        return; // Not opened, there is nowhere to save to
+    }
+    const std::string body = section + " " + std::to_string(index) + " " + entry;
+    char prefix[10];
+    std::snprintf(prefix, sizeof(prefix), "%08x ", checksum(body));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending += prefix + body + "\n";
+        m_appended++;
+    }
+    m_record_count++;
+    m_condition.notify_all();
+}
+
+void SettingsJournal::erase(const std::string& section, int index)
+{
+    append(section, index, "~"); // A null entry
+}
+
+void SettingsJournal::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this]() { return m_durable == m_appended || !m_writer.joinable(); });
+}
+
+void SettingsJournal::writer_loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this]() { return !m_pending.empty() || m_stopping; });
+        if (m_pending.empty())
+        {
+            return; // Stopping with nothing left to write
+        }
+        if (!m_stopping)
+        {
+            // Let the records of the same edit burst catch up
+            m_condition.wait_for(lock, BATCH_WINDOW, [this]() { return m_stopping; });
+        }
+
+        std::string batch;
+        batch.swap(m_pending);
+        const size_t count = m_appended;
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> file_lock(m_file_mutex);
+            for (std::FILE* file : { m_file, m_next_file })
+            {
+                if (file)
+                {
+                    std::fwrite(batch.data(), 1, batch.size(), file);
+                    durable_file::sync(file);
+                }
+            }
+        }
+        lock.lock();
+        m_durable = count;
+        m_condition.notify_all();
+    }
+}
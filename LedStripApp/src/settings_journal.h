@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include <utility>
+
+struct SettingsSnapshot;
+
+// Append-only log of settings changes made since the settings snapshot was written.
+// Every record is one line holding a checksum, the settings section, the entry index and the
+// entry as flow YAML. A background thread writes queued records in batches with one fsync each,
+// so an edit is on disk within a few milliseconds without the UI thread waiting for the disk.
+// Each snapshot starts a new epoch with its own file, settings.<epoch>.journal. Until the new
+// snapshot is on disk, records go to the files of both epochs, so whichever snapshot a crash leaves
+// behind has a complete journal. Files of older epochs are removed after that.
+class SettingsJournal
+{
+public:
+	SettingsJournal() = default;
+	~SettingsJournal();
+
+	// Applies the journal of the snapshot's epoch to it, up to its first torn or corrupt record, and
+	// cuts the torn tail off so records appended later are replayed too. A newer journal belongs to
+	// a snapshot that never reached the disk and its records are in this one as well, it is skipped.
+	// Returns the newest epoch found on disk through newest_epoch.
+	static size_t replay(const std::filesystem::path& directory, uint64_t epoch, SettingsSnapshot& settings, uint64_t& newest_epoch);
+	static void remove_before(const std::filesystem::path& directory, uint64_t epoch);
+
+	void open(const std::filesystem::path& directory, uint64_t epoch); // Later records go to this epoch's file
+	// Later records also go to the next epoch's file, call right before its snapshot is queued.
+	// end_epoch closes the older file once that snapshot is durable. One switch at a time.
+	void begin_epoch(uint64_t epoch);
+	void end_epoch(); // Also removes the journals of older epochs
+	inline bool switching_epoch() const { return m_next_epoch.has_value(); }
+	void append(const std::string& section, int index, const std::string& entry); // Flow YAML, index -1 replaces the whole section
+	void erase(const std::string& section, int index); // Entries after it move as they do in the app
+	void flush(); // Returns once every appended record is durable
+	inline size_t record_count() const { return m_record_count; }
+
+	static constexpr std::chrono::milliseconds BATCH_WINDOW{ 5 }; // Records arriving within this share an fsync
+
+private:
+	static std::filesystem::path file_path(const std::filesystem::path& directory, uint64_t epoch);
+	static std::vector<std::pair<uint64_t, std::filesystem::path>> journal_files(const std::filesystem::path& directory);
+	static size_t replay_file(const std::filesystem::path& path, SettingsSnapshot& settings);
+	void writer_loop();
+
+private:
+	std::filesystem::path m_directory;
+	std::FILE* m_file = nullptr;
+	std::FILE* m_next_file = nullptr; // While switching epochs
+	std::optional<uint64_t> m_next_epoch;
+	std::mutex m_file_mutex; // Held while writing, so the files are never swapped under the writer
+	std::thread m_writer;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::string m_pending;
+	size_t m_appended = 0;
+	size_t m_durable = 0;
+	bool m_stopping = false;
+
+	size_t m_record_count = 0; // In the current epoch, only touched from the UI thread
+};
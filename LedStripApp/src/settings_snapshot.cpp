@@ -0,0 +1,480 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+
+#include "settings_snapshot.h"
+#include "settings_binary.h"
+#include "durable_file.h"
+
+namespace
+{
+    // Entry index i of the app is entry i - 1 of the snapshot, one past the end appends
+    template <typename T>
+    bool put(std::vector<T>& entries, int index, T entry)
+    {
+        if (index < 1 || static_cast<size_t>(index) > entries.size() + 1)
+        {
+            return false;
+        }
+        if (static_cast<size_t>(index) == entries.size() + 1)
+            entries.push_back(std::move(entry));
+        else
+            entries[index - 1] = std::move(entry);
+        return true;
+    }
+
+    // Controllers are a plain vector in the app, the later ones move down
+    template <typename T>
+    bool erase_shifting(std::vector<T>& entries, int index)
+    {
+        if (index < 1 || static_cast<size_t>(index) > entries.size())
+        {
+            return false;
+        }
+        entries.erase(entries.begin() + (index - 1));
+        return true;
+    }
+
+    // Configurations are in a SlotMap in the app, the last one moves into the gap. Controllers that
+    // used the erased one fall back to the default.
+    template <typename T>
+    bool erase_swapping(std::vector<T>& entries, int index, std::vector<ControllerSettings>& controllers, int ControllerSettings::* selected)
+    {
+        if (index < 1 || static_cast<size_t>(index) > entries.size())
+        {
+            return false;
+        }
+        const int last = static_cast<int>(entries.size());
+        if (index != last)
+        {
+            entries[index - 1] = std::move(entries.back());
+        }
+        entries.pop_back();
+        for (ControllerSettings& controller : controllers)
+        {
+            if (controller.*selected == index)
+                controller.*selected = 0;
+            else if (controller.*selected == last)
+                controller.*selected = index;
+        }
+        return true;
+    }
+
+    // Sections map the app index of each entry to it, the file order is usually already right
+    template <typename Read>
+    auto read_section(const YAML::Node& section, Read read)
+    {
+        using Entry = decltype(read(section));
+        std::vector<std::pair<int, Entry>> indexed;
+        indexed.reserve(section.size());
+        for (const auto& entry : section)
+        {
+            indexed.emplace_back(entry.first.as<int>(), read(entry.second));
+        }
+        if (!std::ranges::is_sorted(indexed, {}, &std::pair<int, Entry>::first))
+        {
+            std::ranges::stable_sort(indexed, {}, &std::pair<int, Entry>::first);
+        }
+
+        std::vector<Entry> entries;
+        entries.reserve(indexed.size());
+        for (auto& [index, entry] : indexed)
+        {
+            entries.push_back(std::move(entry));
+        }
+        return entries;
+    }
+
+    template <typename T>
+    void write_section(YAML::Emitter& out, const char* name, const std::vector<T>& entries)
+    {
+        if (entries.empty())
+        {
+            return;
+        }
+        out << YAML::Key << name << YAML::Value << YAML::BeginMap;
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            out << YAML::Key << i + 1 << YAML::Value;
+            settings_yaml::write(out, entries[i]);
+        }
+        out << YAML::EndMap;
+    }
+}
+
+namespace settings_yaml
+{
+    void write(YAML::Emitter& out, const ControllerSettings& settings)
+    {
+        out << YAML::BeginMap;
+        out << YAML::Key << "name" << YAML::Value << settings.name;
+        out << YAML::Key << "selected_led_config" << YAML::Value << settings.selected_led_config;
+        out << YAML::Key << "selected_timer_config" << YAML::Value << settings.selected_timer_config;
+        out << YAML::Key << "timer_enabled" << YAML::Value << settings.timer_enabled;
+        out << YAML::Key << "streaming_enabled" << YAML::Value << settings.streaming_enabled;
+        out << YAML::Key << "max_command_rate" << YAML::Value << settings.max_command_rate;
+        out << YAML::Key << "dithering_enabled" << YAML::Value << settings.dithering_enabled;
+        out << YAML::EndMap;
+    }
+
+    void write(YAML::Emitter& out, const LEDConfiguration& config)
+    {
+        out << YAML::BeginMap;
+        out << YAML::Key << "name" << YAML::Value << config.name;
+        out << YAML::Key << "device_on" << YAML::Value << config.device_on;
+        out << YAML::Key << "color" << YAML::Value << YAML::Flow << YAML::BeginSeq; // List for color values
+        out << config.color[0] << config.color[1] << config.color[2];
+        out << YAML::EndSeq;
+        out << YAML::Key << "brightness" << YAML::Value << config.brightness;
+        out << YAML::Key << "mode" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "index" << YAML::Value << config.mode.index;
+        out << YAML::Key << "speed" << YAML::Value << config.mode.speed;
+        out << YAML::EndMap;
+        out << YAML::Key << "curve" << YAML::Value << static_cast<int>(config.curve);
+        out << YAML::EndMap;
+    }
+
+    void write(YAML::Emitter& out, const TimerSettings& settings)
+    {
+        out << YAML::BeginMap;
+        out << YAML::Key << "name" << YAML::Value << settings.name;
+        out << YAML::Key << "start" << YAML::Value << settings.start;
+        out << YAML::Key << "end" << YAML::Value << settings.end;
+        out << YAML::Key << "repeat" << YAML::Value << settings.repeat;
+        out << YAML::Key << "inverse" << YAML::Value << settings.inverse;
+        out << YAML::Key << "anchor" << YAML::Value << static_cast<int>(settings.anchor);
+        out << YAML::Key << "wall_clock" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "on_reference" << YAML::Value << static_cast<int>(settings.wall_clock.on.reference);
+        out << YAML::Key << "on_offset" << YAML::Value << settings.wall_clock.on.offset_minutes;
+        out << YAML::Key << "off_reference" << YAML::Value << static_cast<int>(settings.wall_clock.off.reference);
+        out << YAML::Key << "off_offset" << YAML::Value << settings.wall_clock.off.offset_minutes;
+        out << YAML::Key << "weekdays" << YAML::Value << static_cast<int>(settings.wall_clock.weekdays);
+        out << YAML::EndMap;
+        out << YAML::EndMap;
+    }
+
+    void write(YAML::Emitter& out, const std::vector<ControllerGroup>& groups)
+    {
+        out << YAML::BeginSeq;
+        for (const ControllerGroup& group : groups)
+        {
+            out << YAML::BeginMap;
+            out << YAML::Key << "name" << YAML::Value << group.name;
+            out << YAML::Key << "members" << YAML::Value << YAML::BeginSeq;
+            for (const std::string& member : group.members)
+            {
+                out << member;
+            }
+            out << YAML::EndSeq;
+            out << YAML::EndMap;
+        }
+        out << YAML::EndSeq;
+    }
+
+    void write(YAML::Emitter& out, const SettingsSnapshot& snapshot)
+    {
+        out << YAML::BeginMap;
+        write_section(out, "controllers", snapshot.controllers);
+        write_section(out, "led_configs", snapshot.led_configs);
+        write_section(out, "timer_configs", snapshot.timer_configs);
+        out << YAML::Key << "groups" << YAML::Value;
+        write(out, snapshot.groups);
+        out << YAML::Key << "journal_epoch" << YAML::Value << snapshot.journal_epoch;
+        out << YAML::EndMap;
+    }
+
+    ControllerSettings read_controller(const YAML::Node& node)
+    {
+        ControllerSettings settings;
+        for (const auto& field : node)
+        {
+            const std::string& key = field.first.Scalar();
+            const YAML::Node& value = field.second;
+            if (key == "name")
+                settings.name = value.as<std::string>();
+            else if (key == "selected_led_config")
+                settings.selected_led_config = value.as<int>();
+            else if (key == "selected_timer_config")
+                settings.selected_timer_config = value.as<int>();
+            else if (key == "timer_enabled")
+                settings.timer_enabled = value.as<bool>();
+            else if (key == "streaming_enabled")
+                settings.streaming_enabled = value.as<bool>();
+            else if (key == "max_command_rate")
+                settings.max_command_rate = value.as<float>();
+            else if (key == "dithering_enabled")
+                settings.dithering_enabled = value.as<bool>();
+        }
+        return settings;
+    }
+
+    LEDConfiguration read_led_config(const YAML::Node& node)
+    {
+        LEDConfiguration config("", false, { 1.0f, 1.0f, 1.0f }, 1.0f, { 0, 0.0f });
+        for (const auto& field : node)
+        {
+            const std::string& key = field.first.Scalar();
+            const YAML::Node& value = field.second;
+            if (key == "name")
+                config.name = value.as<std::string>();
+            else if (key == "device_on")
+                config.device_on = value.as<bool>();
+            else if (key == "color" && value.size() == 3)
+            {
+                size_t channel = 0;
+                for (const YAML::Node& component : value)
+                {
+                    config.color[channel++] = component.as<float>();
+                }
+            }
+            else if (key == "brightness")
+                config.brightness = value.as<float>();
+            else if (key == "mode")
+            {
+                for (const auto& mode_field : value)
+                {
+                    const std::string& mode_key = mode_field.first.Scalar();
+                    if (mode_key == "index")
+                        config.mode.index = mode_field.second.as<int>();
+                    else if (mode_key == "speed")
+                        config.mode.speed = mode_field.second.as<float>();
+                }
+            }
+            else if (key == "curve")
+                config.curve = static_cast<ColorCurve>(std::clamp(value.as<int>(), 0, static_cast<int>(std::size(color_pipeline::curve_strings)) - 1));
+        }
+        return config;
+    }
+
+    TimerSettings read_timer_config(const YAML::Node& node)
+    {
+        TimerSettings settings;
+        for (const auto& field : node)
+        {
+            const std::string& key = field.first.Scalar();
+            const YAML::Node& value = field.second;
+            if (key == "name")
+                settings.name = value.as<std::string>();
+            else if (key == "start")
+                settings.start = value.as<float>();
+            else if (key == "end")
+                settings.end = value.as<float>();
+            else if (key == "repeat")
+                settings.repeat = value.as<int>();
+            else if (key == "inverse")
+                settings.inverse = value.as<bool>();
+            else if (key == "anchor")
+                settings.anchor = static_cast<TimerAnchor>(value.as<int>());
+            else if (key == "wall_clock")
+            {
+                for (const auto& clock_field : value)
+                {
+                    const std::string& clock_key = clock_field.first.Scalar();
+                    const YAML::Node& clock_value = clock_field.second;
+                    if (clock_key == "on_reference")
+                        settings.wall_clock.on.reference = static_cast<TimeReference>(clock_value.as<int>());
+                    else if (clock_key == "on_offset")
+                        settings.wall_clock.on.offset_minutes = clock_value.as<int>();
+                    else if (clock_key == "off_reference")
+                        settings.wall_clock.off.reference = static_cast<TimeReference>(clock_value.as<int>());
+                    else if (clock_key == "off_offset")
+                        settings.wall_clock.off.offset_minutes = clock_value.as<int>();
+                    else if (clock_key == "weekdays")
+                        settings.wall_clock.weekdays = static_cast<uint8_t>(clock_value.as<int>());
+                }
+            }
+        }
+        return settings;
+    }
+
+    std::vector<ControllerGroup> read_groups(const YAML::Node& node)
+    {
+        std::vector<ControllerGroup> groups;
+        groups.reserve(node.size());
+        for (const YAML::Node& group_yaml : node)
+        {
+            ControllerGroup& group = groups.emplace_back();
+            for (const auto& field : group_yaml)
+            {
+                const std::string& key = field.first.Scalar();
+                if (key == "name")
+                    group.name = field.second.as<std::string>();
+                else if (key == "members")
+                    group.members = field.second.as<std::vector<std::string>>();
+            }
+        }
+        return groups;
+    }
+
+    SettingsSnapshot read_document(const YAML::Node& settings)
+    {
+        SettingsSnapshot snapshot;
+        for (const auto& section : settings)
+        {
+            const std::string& key = section.first.Scalar();
+            if (key == "controllers")
+                snapshot.controllers = read_section(section.second, read_controller);
+            else if (key == "led_configs")
+                snapshot.led_configs = read_section(section.second, read_led_config);
+            else if (key == "timer_configs")
+                snapshot.timer_configs = read_section(section.second, read_timer_config);
+            else if (key == "groups")
+                snapshot.groups = read_groups(section.second);
+            else if (key == "journal_epoch")
+                snapshot.journal_epoch = section.second.as<uint64_t>();
+        }
+        return snapshot;
+    }
+
+    bool apply(SettingsSnapshot& snapshot, const std::string& section, int index, const YAML::Node& entry)
+    {
+        if (entry.IsNull())
+        {
+            if (section == "controllers")
+                return erase_shifting(snapshot.controllers, index);
+            if (section == "led_configs")
+                return erase_swapping(snapshot.led_configs, index, snapshot.controllers, &ControllerSettings::selected_led_config);
+            if (section == "timer_configs")
+                return erase_swapping(snapshot.timer_configs, index, snapshot.controllers, &ControllerSettings::selected_timer_config);
+            return false;
+        }
+        if (section == "controllers")
+            return put(snapshot.controllers, index, read_controller(entry));
+        if (section == "led_configs")
+            return put(snapshot.led_configs, index, read_led_config(entry));
+        if (section == "timer_configs")
+            return put(snapshot.timer_configs, index, read_timer_config(entry));
+        if (section == "groups" && index < 0)
+        {
+            snapshot.groups = read_groups(entry);
+            return true;
+        }
+        return false;
+    }
+}
+
+std::optional<SettingsSnapshot> load_snapshot(const std::filesystem::path& directory)
+{
+    const std::filesystem::path yaml_file = directory / "settings.yaml";
+    const std::filesystem::path binary_file = directory / "settings.bin";
+
+    // The writer saves settings.yaml first, one that is newer was edited by hand
+    std::error_code error;
+    const bool has_yaml = std::filesystem::exists(yaml_file, error);
+    const bool yaml_edited = has_yaml && std::filesystem::exists(binary_file, error)
+        && std::filesystem::last_write_time(yaml_file, error) > std::filesystem::last_write_time(binary_file, error);
+    if (!yaml_edited)
+    {
+        if (std::optional<SettingsImage> image = SettingsImage::read(binary_file))
+        {
+            return image->snapshot();
+        }
+    }
+    else
+    {
+        std::cout << "[Info] settings.yaml was edited, importing it." << std::endl;
+    }
+
+    std::ifstream file(yaml_file);
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+    return settings_yaml::read_document(YAML::Load(file));
+}
+
+SettingsWriter::~SettingsWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    if (m_writer.joinable())
+    {
+        m_writer.join();
+    }
+}
+
+void SettingsWriter::open(const std::filesystem::path& directory)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_directory = directory;
+    }
+    if (!m_writer.joinable())
+    {
+        m_writer = std::thread(&SettingsWriter::writer_loop, this);
+    }
+}
+
+void SettingsWriter::write(SettingsSnapshot snapshot)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = std::move(snapshot);
+    }
+    m_condition.notify_all();
+}
+
+void SettingsWriter::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this]() { return (!m_pending && !m_writing) || !m_writer.joinable(); });
+}
+
+void SettingsWriter::writer_loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this]() { return m_pending || m_stopping; });
+        if (m_stopping)
+        {
+            return;
+        }
+
+        const SettingsSnapshot snapshot = std::move(*m_pending);
+        m_pending.reset();
+        m_writing = true;
+        lock.unlock();
+        write_file(snapshot);
+        lock.lock();
+        m_writing = false;
+        m_condition.notify_all();
+    }
+}
+
+void SettingsWriter::write_file(const SettingsSnapshot& snapshot)
+{
+    try
+    {
+        std::filesystem::create_directories(m_directory);
+
+        YAML::Emitter emitter;
+        settings_yaml::write(emitter, snapshot);
+        if (!durable_file::write_atomically(m_directory / "settings.yaml", emitter.c_str(), emitter.size()))
+        {
+            std::cout << "[Error] Failed to save settings: cannot replace settings.yaml." << std::endl;
+            return;
+        }
+
+        // Written last, so it is never older than the settings.yaml it was saved with
+        const std::string image = settings_binary::encode(snapshot);
+        if (!durable_file::write_atomically(m_directory / "settings.bin", image.data(), image.size()))
+        {
+            std::cout << "[Error] Failed to save settings: cannot replace settings.bin." << std::endl;
+            return;
+        }
+
+        // The journal switches to this epoch and drops the older ones once it sees this
+        m_durable_epoch = snapshot.journal_epoch;
+        std::cout << "[Info] Saved settings." << std::endl;
+    }
+    catch (const std::exception& ex)
+    {
+        // Handle YAML exceptions (e.g., serialization errors) and file system errors
+        std::cout << "[Error] Failed to save settings: " << ex.what() << std::endl;
+    }
+}
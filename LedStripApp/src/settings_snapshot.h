@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <filesystem>
+#include <cstdint>
+
+#include "yaml-cpp/yaml.h"
+#include "led_configuration.h"
+#include "timer_configuration.h"
+#include "controller_group.h"
+
+// Persisted part of a controller
+struct ControllerSettings
+{
+	std::string name;
+	int selected_led_config = 0;
+	int selected_timer_config = 0;
+	bool timer_enabled = true;
+	bool streaming_enabled = true;
+	float max_command_rate = DEFAULT_COMMAND_RATE;
+	bool dithering_enabled = true;
+
+	static constexpr float DEFAULT_COMMAND_RATE = 30.0f; // Color and mode commands per second
+};
+
+// Persisted part of a timer configuration, without its progress and plot cache
+struct TimerSettings
+{
+	std::string name;
+	float start = 0.0f;
+	float end = 10.0f;
+	int repeat = 1;
+	bool inverse = false;
+	TimerAnchor anchor = TimerAnchor::RELATIVE;
+	WallClockRule wall_clock;
+};
+
+// Plain copy of everything the settings files hold, taken on the UI thread. The default entries at
+// index 0 are not part of it, entry i here is entry i + 1 in the app.
+struct SettingsSnapshot
+{
+	std::vector<ControllerSettings> controllers;
+	std::vector<LEDConfiguration> led_configs;
+	std::vector<TimerSettings> timer_configs;
+	std::vector<ControllerGroup> groups;
+	uint64_t journal_epoch = 0; // Journals of this epoch and later are not part of the snapshot yet
+};
+
+namespace settings_yaml
+{
+	// Streamed straight into the emitter, no node graph is built
+	void write(YAML::Emitter& out, const ControllerSettings& settings);
+	void write(YAML::Emitter& out, const LEDConfiguration& config);
+	void write(YAML::Emitter& out, const TimerSettings& settings);
+	void write(YAML::Emitter& out, const std::vector<ControllerGroup>& groups);
+	void write(YAML::Emitter& out, const SettingsSnapshot& snapshot);
+
+	// One entry as a single line of flow YAML, the form journal records hold
+	template <typename T>
+	std::string flow(const T& entry)
+	{
+		YAML::Emitter out;
+		out.SetMapFormat(YAML::Flow);
+		out.SetSeqFormat(YAML::Flow);
+		write(out, entry);
+		return out.c_str();
+	}
+
+	// Each mapping is walked once, missing keys keep their defaults and unknown ones are ignored
+	ControllerSettings read_controller(const YAML::Node& node);
+	LEDConfiguration read_led_config(const YAML::Node& node);
+	TimerSettings read_timer_config(const YAML::Node& node);
+	std::vector<ControllerGroup> read_groups(const YAML::Node& node);
+	SettingsSnapshot read_document(const YAML::Node& settings);
+
+	// Applies one journal record, false if it points past the end of its section. A null entry
+	// erases the entry at the index.
+	bool apply(SettingsSnapshot& snapshot, const std::string& section, int index, const YAML::Node& entry);
+}
+
+// Reads settings.bin, or settings.yaml when there is no valid settings.bin or settings.yaml was
+// edited after it. Empty if neither exists, throws YAML::Exception for an unreadable settings.yaml.
+std::optional<SettingsSnapshot> load_snapshot(const std::filesystem::path& directory);
+
+// Writes snapshots on a background thread, as settings.yaml and then settings.bin. Each goes to a
+// temporary file that is synced and then renamed over the old one, so a file on disk is always
+// either the old or the new version.
+class SettingsWriter
+{
+public:
+	SettingsWriter() = default;
+	~SettingsWriter(); // Finishes the snapshot being written, one still waiting is dropped
+
+	void open(const std::filesystem::path& directory);
+	void write(SettingsSnapshot snapshot); // Replaces a snapshot that is still waiting
+	void wait(); // Returns once nothing is waiting or being written
+	inline uint64_t durable_epoch() const { return m_durable_epoch; } // Of the last snapshot fully on disk
+
+private:
+	void writer_loop();
+	void write_file(const SettingsSnapshot& snapshot);
+
+private:
+	std::filesystem::path m_directory;
+	std::thread m_writer;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::optional<SettingsSnapshot> m_pending;
+	bool m_writing = false;
+	bool m_stopping = false;
+	std::atomic<uint64_t> m_durable_epoch = 0;
+};
@@ -0,0 +1,88 @@
+#include "simpleble_transport.h"
+#include "simpleble/Exceptions.h"
+
+std::string SimpleBLETransport::identifier()
+{
+    return m_peripheral.identifier();
+}
+
+void SimpleBLETransport::connect()
+{
+    try
+    {
+        m_peripheral.connect();
+    }
+    catch (const SimpleBLE::Exception::BaseException& e)
+    {
+        throw TransportError(e.what());
+    }
+}
+
+void SimpleBLETransport::disconnect()
+{
+    try
+    {
+        m_peripheral.disconnect();
+    }
+    catch (const SimpleBLE::Exception::BaseException& e)
+    {
+        throw TransportError(e.what());
+    }
+}
+
+bool SimpleBLETransport::is_connected()
+{
+    return m_peripheral.is_connected();
+}
+
+bool SimpleBLETransport::can_write_command(const SimpleBLE::BluetoothUUID& service_uuid, const SimpleBLE::BluetoothUUID& characteristic_uuid)
+{
+    for (SimpleBLE::Service& service : m_peripheral.services())
+    {
+        if (service.uuid() != service_uuid)
+        {
+            continue;
+        }
+        for (SimpleBLE::Characteristic& characteristic : service.characteristics())
+        {
+            if (characteristic.uuid() == characteristic_uuid)
+            {
+                return characteristic.can_write_command();
+            }
+        }
+    }
+    return false;
+}
+
+void SimpleBLETransport::write_request(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data)
+{
+    try
+    {
+        m_peripheral.write_request(service, characteristic, data);
+    }
+    catch (const SimpleBLE::Exception::BaseException& e)
+    {
+        throw TransportError(e.what());
+    }
+}
+
+void SimpleBLETransport::write_command(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data)
+{
+    try
+    {
+        m_peripheral.write_command(service, characteristic, data);
+    }
+    catch (const SimpleBLE::Exception::BaseException& e)
+    {
+        throw TransportError(e.what());
+    }
+}
+
+void SimpleBLETransport::set_callback_on_disconnected(std::function<void()> on_disconnected)
+{
+    if (!on_disconnected)
+    {
+        on_disconnected = []() {}; // SimpleBLE has no way to unset a callback
+    }
+    m_peripheral.set_callback_on_disconnected(on_disconnected);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ble_transport.h"
+#include "simpleble/SimpleBLE.h"
+
+// Transport for real devices, translates SimpleBLE exceptions into TransportError
+class SimpleBLETransport : public BLETransport
+{
+public:
+	explicit SimpleBLETransport(SimpleBLE::Peripheral peripheral) : m_peripheral(peripheral) {}
+	~SimpleBLETransport() override = default;
+
+	std::string identifier() override;
+	void connect() override;
+	void disconnect() override;
+	bool is_connected() override;
+	bool can_write_command(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic) override;
+	void write_request(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data) override;
+	void write_command(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data) override;
+	void set_callback_on_disconnected(std::function<void()> on_disconnected) override;
+
+private:
+	SimpleBLE::Peripheral m_peripheral;
+};
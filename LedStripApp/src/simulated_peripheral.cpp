@@ -0,0 +1,246 @@
+#include <thread>
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+
+#include "simulated_peripheral.h"
+
+namespace
+{
+    template <typename T>
+    bool parse_number(std::string_view text, T& value)
+    {
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    template <typename Duration>
+    bool parse_milliseconds(std::string_view text, Duration& duration)
+    {
+        double milliseconds = 0.0;
+        if (!parse_number(text, milliseconds) || milliseconds < 0.0)
+        {
+            return false;
+        }
+        duration = std::chrono::duration_cast<Duration>(std::chrono::duration<double, std::milli>(milliseconds));
+        return true;
+    }
+
+    bool parse_probability(std::string_view text, float& probability)
+    {
+        return parse_number(text, probability) && probability >= 0.0f && probability <= 1.0f;
+    }
+}
+
+std::optional<SimulationProfile> SimulationProfile::parse(std::string_view options)
+{
+    SimulationProfile profile;
+    while (!options.empty())
+    {
+        const std::string_view option = options.substr(0, options.find(','));
+        options.remove_prefix(std::min(options.size(), option.size() + 1));
+
+        const size_t split = option.find('=');
+        const std::string_view key = option.substr(0, split);
+        const std::string_view value = split == std::string_view::npos ? std::string_view() : option.substr(split + 1);
+        bool valid = false;
+        if (key == "latency")
+            valid = parse_milliseconds(value, profile.latency);
+        else if (key == "jitter")
+            valid = parse_milliseconds(value, profile.jitter);
+        else if (key == "command_latency")
+            valid = parse_milliseconds(value, profile.command_latency);
+        else if (key == "timeout")
+            valid = parse_milliseconds(value, profile.timeout);
+        else if (key == "connect_time")
+            valid = parse_milliseconds(value, profile.connect_time);
+        else if (key == "loss")
+            valid = parse_probability(value, profile.loss_rate);
+        else if (key == "disconnect")
+            valid = parse_probability(value, profile.disconnect_rate);
+        else if (key == "write_command" && (value == "0" || value == "1"))
+        {
+            profile.supports_write_command = value == "1";
+            valid = true;
+        }
+        else if (key == "seed")
+            valid = parse_number(value, profile.seed);
+
+        if (!valid)
+        {
+            std::cout << "[Error] Invalid simulation option \'" << option << "\'." << std::endl;
+            return std::nullopt;
+        }
+    }
+    return profile;
+}
+
+SimulatedPeripheral::SimulatedPeripheral(std::string identifier, SimulationProfile profile)
+    : m_identifier(identifier), m_profile(profile), m_rng(profile.seed)
+{
+}
+
+std::string SimulatedPeripheral::identifier()
+{
+    return m_identifier;
+}
+
+void SimulatedPeripheral::connect()
+{
+    std::this_thread::sleep_for(m_profile.connect_time);
+    m_connected = true;
+}
+
+void SimulatedPeripheral::disconnect()
+{
+    m_connected = false;
+}
+
+bool SimulatedPeripheral::is_connected()
+{
+    return m_connected;
+}
+
+bool SimulatedPeripheral::can_write_command([[maybe_unused]] const SimpleBLE::BluetoothUUID& service, [[maybe_unused]] const SimpleBLE::BluetoothUUID& characteristic)
+{
+    return m_profile.supports_write_command;
+}
+
+void SimulatedPeripheral::write_request([[maybe_unused]] const SimpleBLE::BluetoothUUID& service, [[maybe_unused]] const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data)
+{
+    check_link();
+
+    std::chrono::microseconds delay;
+    bool lost;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        lost = roll(m_profile.loss_rate);
+        delay = round_trip();
+    }
+
+    if (lost)
+    {
+        std::this_thread::sleep_for(m_profile.timeout);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.lost_writes++;
+        throw TransportError("Simulated write request to '" + m_identifier + "' timed out.");
+    }
+
+    std::this_thread::sleep_for(delay);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    apply(data);
+    m_stats.acknowledged_writes++;
+}
+
+void SimulatedPeripheral::write_command([[maybe_unused]] const SimpleBLE::BluetoothUUID& service, [[maybe_unused]] const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data)
+{
+    if (!m_profile.supports_write_command)
+    {
+        throw TransportError("Simulated device '" + m_identifier + "' does not support write without response.");
+    }
+    check_link();
+
+    std::this_thread::sleep_for(m_profile.command_latency);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.unacknowledged_writes++;
+    if (roll(m_profile.loss_rate))
+    {
+        m_stats.lost_writes++; // Nobody notices
+        return;
+    }
+    apply(data);
+}
+
+void SimulatedPeripheral::set_callback_on_disconnected(std::function<void()> on_disconnected)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_on_disconnected = on_disconnected;
+}
+
+SimulatedDeviceState SimulatedPeripheral::state()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_state;
+}
+
+SimulationStats SimulatedPeripheral::stats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void SimulatedPeripheral::drop_link()
+{
+    std::function<void()> on_disconnected;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_connected.exchange(false))
+        {
+            return;
+        }
+        m_stats.disconnects++;
+        on_disconnected = m_on_disconnected;
+    }
+
+    if (on_disconnected)
+    {
+        on_disconnected();
+    }
+}
+
+bool SimulatedPeripheral::roll(float probability)
+{
+    return probability > 0.0f && std::uniform_real_distribution<float>(0.0f, 1.0f)(m_rng) < probability;
+}
+
+std::chrono::microseconds SimulatedPeripheral::round_trip()
+{
+    const long long jitter = m_profile.jitter.count();
+    const long long offset = jitter > 0 ? std::uniform_int_distribution<long long>(-jitter, jitter)(m_rng) : 0;
+    return std::max(std::chrono::microseconds(0), m_profile.latency + std::chrono::microseconds(offset));
+}
+
+void SimulatedPeripheral::apply(const SimpleBLE::ByteArray& data)
+{
+    auto byte = [&data](size_t index) { return static_cast<uint8_t>(data[index]); };
+
+    if (data.size() == 3 && byte(0) == 0xCC && byte(2) == 0x33 && (byte(1) == 0x23 || byte(1) == 0x24))
+    {
+        m_state.device_on = byte(1) == 0x23;
+    }
+    else if (data.size() == 7 && byte(0) == 0x56 && byte(5) == 0xF0 && byte(6) == 0xAA)
+    {
+        m_state.red = byte(1);
+        m_state.green = byte(2);
+        m_state.blue = byte(3);
+        m_state.mode = 0; // Static color replaces the running mode
+    }
+    else if (data.size() == 4 && byte(0) == 0xBB && byte(3) == 0x44)
+    {
+        m_state.mode = byte(1);
+        m_state.speed = byte(2);
+    }
+    else
+    {
+        m_stats.malformed_writes++;
+    }
+}
+
+void SimulatedPeripheral::check_link()
+{
+    bool drop;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_connected)
+        {
+            throw TransportError("Simulated device '" + m_identifier + "' is not connected.");
+        }
+        drop = roll(m_profile.disconnect_rate);
+    }
+
+    if (drop)
+    {
+        drop_link();
+        throw TransportError("Simulated device '" + m_identifier + "' dropped the link.");
+    }
+}
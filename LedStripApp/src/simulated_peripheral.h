@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <optional>
+#include <string_view>
+#include <cstdint>
+
+#include "ble_transport.h"
+
+// Link characteristics of a simulated device
+struct SimulationProfile
+{
+	std::chrono::microseconds latency{ 15000 };       // ATT round trip of an acknowledged write
+	std::chrono::microseconds jitter{ 5000 };         // Uniform +- on top of the latency
+	std::chrono::microseconds command_latency{ 1500 }; // Time to queue a write without response
+	std::chrono::milliseconds timeout{ 500 };         // Time until a lost acknowledged write fails
+	std::chrono::milliseconds connect_time{ 300 };
+	float loss_rate = 0.0f;       // Probability a write is lost
+	float disconnect_rate = 0.0f; // Probability the link drops on a write
+	bool supports_write_command = true;
+	uint32_t seed = std::random_device{}(); // Same seed, same sequence of losses and delays
+
+	// Comma separated key=value pairs, times in milliseconds, e.g. "loss=0.05,disconnect=0.01,seed=7".
+	// Keys: latency, jitter, command_latency, timeout, connect_time, loss, disconnect, write_command, seed.
+	// Keys left out keep their defaults. Empty if an option is unknown or out of range.
+	static std::optional<SimulationProfile> parse(std::string_view options);
+};
+
+// What the simulated strip currently shows, decoded from the 0xCC/0x56/0xBB command set
+struct SimulatedDeviceState
+{
+	bool device_on = false;
+	uint8_t red = 0;
+	uint8_t green = 0;
+	uint8_t blue = 0;
+	uint8_t mode = 0;
+	uint8_t speed = 0;
+};
+
+struct SimulationStats
+{
+	uint64_t acknowledged_writes = 0;
+	uint64_t unacknowledged_writes = 0;
+	uint64_t lost_writes = 0;
+	uint64_t malformed_writes = 0;
+	uint64_t disconnects = 0;
+};
+
+// In-process stand-in for an LED controller, does not depend on a bluetooth stack
+class SimulatedPeripheral : public BLETransport
+{
+public:
+	explicit SimulatedPeripheral(std::string identifier, SimulationProfile profile = SimulationProfile());
+	~SimulatedPeripheral() override = default;
+
+	std::string identifier() override;
+	void connect() override;
+	void disconnect() override;
+	bool is_connected() override;
+	// A simulated device has a single characteristic, the service and characteristic are not checked
+	bool can_write_command(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic) override;
+	void write_request(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data) override;
+	void write_command(const SimpleBLE::BluetoothUUID& service, const SimpleBLE::BluetoothUUID& characteristic, const SimpleBLE::ByteArray& data) override;
+	void set_callback_on_disconnected(std::function<void()> on_disconnected) override;
+
+	SimulatedDeviceState state();
+	SimulationStats stats();
+	void drop_link(); // Simulates the device going out of range
+
+	static constexpr const char* IDENTIFIER_PREFIX = "SIM-";
+
+private:
+	bool roll(float probability);
+	std::chrono::microseconds round_trip();
+	void apply(const SimpleBLE::ByteArray& data);
+	void check_link(); // Throws if the link is down or drops now
+
+private:
+	std::string m_identifier;
+	SimulationProfile m_profile;
+	std::atomic_bool m_connected = false;
+
+	std::mutex m_mutex;
+	std::mt19937 m_rng;
+	SimulatedDeviceState m_state;
+	SimulationStats m_stats;
+	std::function<void()> m_on_disconnected;
+};
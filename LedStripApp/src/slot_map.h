@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <ranges>
+#include <optional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+// Owns entries behind generational handles. A handle resolves with one bounds and one generation
+// check, and once its entry is erased it resolves to nullptr, even after the slot is reused, so
+// nothing holding it has to be found and renumbered. Entries are also kept dense, in the order the
+// UI lists and the settings files address them by position. Erasing fills the gap with the last
+// entry instead of shifting the rest.
+template <typename T>
+class SlotMap
+{
+public:
+	struct Handle
+	{
+		uint32_t slot = UINT32_MAX; // Default handles resolve to nullptr
+		uint32_t generation = 0;
+
+		bool operator==(const Handle& other) const = default;
+	};
+
+	Handle insert(std::unique_ptr<T> value)
+	{
+		uint32_t slot;
+		if (!m_free.empty())
+		{
+			slot = m_free.back();
+			m_free.pop_back();
+		}
+		else
+		{
+			slot = static_cast<uint32_t>(m_slots.size());
+			m_slots.emplace_back();
+		}
+		m_slots[slot].value = std::move(value);
+		m_slots[slot].position = m_order.size();
+
+		const Handle handle = { slot, m_slots[slot].generation };
+		m_order.push_back(handle);
+		return handle;
+	}
+
+	// Every copy of the handle goes stale. The last entry moves into the erased position, nothing
+	// else moves.
+	void erase(Handle handle)
+	{
+		if (!get(handle))
+		{
+			return;
+		}
+		Slot& slot = m_slots[handle.slot];
+		const Handle last = m_order.back();
+		m_order[slot.position] = last;
+		m_slots[last.slot].position = slot.position;
+		m_order.pop_back();
+		slot.value.reset();
+		slot.generation++;
+		m_free.push_back(handle.slot);
+	}
+
+	inline T* get(Handle handle) const
+	{
+		return handle.slot < m_slots.size() && m_slots[handle.slot].generation == handle.generation ? m_slots[handle.slot].value.get() : nullptr;
+	}
+
+	// Positional access
+	inline size_t size() const { return m_order.size(); }
+	inline Handle handle(size_t position) const { return m_order.at(position); } // Throws std::out_of_range
+	inline T& operator[](size_t position) const { return *m_slots[m_order[position].slot].value; }
+	inline std::optional<size_t> position(Handle handle) const
+	{
+		return get(handle) ? std::optional<size_t>(m_slots[handle.slot].position) : std::nullopt;
+	}
+
+	// All entries in order
+	inline auto values() const
+	{
+		return m_order | std::views::transform([this](Handle handle) -> T& { return *m_slots[handle.slot].value; });
+	}
+
+private:
+	struct Slot
+	{
+		std::unique_ptr<T> value; // Boxed, pointers to entries stay valid while the slots grow
+		uint32_t generation = 0;
+		size_t position = 0; // In m_order
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_free;
+	std::vector<Handle> m_order;
+};
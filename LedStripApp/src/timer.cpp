@@ -1,80 +1,319 @@
 #include <iostream>
 #include <ranges>
+#include <algorithm>
+#include <cmath>
 
 #include "timer.h"
 #include "app.h"
 
-Timer::Timer(App* app) : m_app(app), m_start_time(clock::now()), m_delta_time_s(0.0f), m_paused(true)
+namespace
 {
+    // Drops the schedules that are gone or changed, leaves only those that need (re)starting in wanted
+    template <typename Scheduled, typename Schedule, typename Cancel>
+    void diff_schedules(std::unordered_map<LEDController*, Scheduled>& current, std::unordered_map<LEDController*, Schedule>& wanted, Cancel cancel)
+    {
+        for (auto it = current.begin(); it != current.end();)
+        {
+            auto schedule = wanted.find(it->first);
+            if (schedule != wanted.end() && schedule->second == it->second.schedule)
+            {
+                wanted.erase(schedule);
+                ++it;
+                continue;
+            }
+            cancel(it->second.next_edge);
+            it = current.erase(it);
+        }
+    }
+}
+
+Timer::Timer(App* app)
+    : m_app(app), m_start_time(clock::now()), m_paused_elapsed(0), m_delta_time_s(0.0f), m_paused(true),
+    m_wall_edges(wall_ticks(std::chrono::system_clock::now()))
+{
+    m_thread = std::thread(&Timer::scheduler_loop, this);
+}
+
+Timer::~Timer()
+{
+    shutdown();
 }
 
 bool Timer::update()
 {
+    // Only refreshes what the UI shows, the edges themselves are fired by the scheduler thread
+    for (size_t i = 1; i < m_app->m_led_controllers.size(); i++)
+    {
+        m_app->m_led_controllers[i]->sync_timer_state();
+    }
+
     if (m_paused) {
         return false;
     }
 
     m_delta_time_s = std::chrono::duration<float>(clock::now() - m_start_time).count();
+    for (size_t i = 1; i < m_app->m_led_controllers.size(); i++)
+    {
+        TimerConfiguration* timer_config = m_app->m_led_controllers[i]->timer_config();
+        if (timer_config->anchor == TimerAnchor::RELATIVE && !timer_config->is_done())
+        {
+            timer_config->update_progress(m_delta_time_s);
+        }
+    }
+
+    return true;
+}
+
+void Timer::pause(bool pause)
+{
+    if (pause == m_paused)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (pause == false)
+        {
+            m_start_time = clock::now() - m_paused_elapsed;
+        }
+        else
+        {
+            m_paused_elapsed = clock::now() - m_start_time;
+            m_delta_time_s = std::chrono::duration<float>(m_paused_elapsed).count();
+        }
+
+        m_paused = pause;
+        rebuild_edges();
+    }
+    m_condition.notify_all();
+}
+
+void Timer::reset()
+{
+    pause(true);
 
-    auto in_active_range = [this](const TimerConfiguration* timer_config) -> bool
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_paused_elapsed = nanoseconds(0);
+    m_delta_time_s = 0.0f;
+    for (size_t i = 1; i < m_app->m_timer_configs.size(); i++)
     {
-        const float cycle_duration = timer_config->end;
-        
-        return (std::fmod(m_delta_time_s, cycle_duration) > timer_config->start) &&
-               (std::fmod(m_delta_time_s, cycle_duration) < timer_config->end);
-    };
+        m_app->m_timer_configs[i].update_progress(0.0f);
+    }
+}
 
+void Timer::reschedule()
+{
+    std::unordered_map<LEDController*, Schedule> schedules;
+    std::unordered_map<LEDController*, WallSchedule> wall_schedules;
     for (size_t i = 1; i < m_app->m_led_controllers.size(); i++)
     {
         LEDController* controller = m_app->m_led_controllers[i].get();
-
-        if (controller->timer_config()->is_done())
+        TimerConfiguration* timer_config = controller->timer_config();
+        if (!controller->m_timer_enabled || timer_config == nullptr)
         {
             continue;
         }
-        controller->timer_config()->update_progress(m_delta_time_s);
 
-        if (in_active_range(controller->timer_config()))
+        if (timer_config->anchor == TimerAnchor::WALL_CLOCK)
         {
-            if (!controller->is_device_on() != controller->timer_config()->inverse)
-            {
-                m_app->m_led_controllers[i]->toggle_device();
-            }
+            wall_schedules[controller] = { controller, timer_config->wall_clock, timer_config->inverse };
         }
-        else
+        else if (timer_config->start < timer_config->end)
         {
-            if (controller->is_device_on() != controller->timer_config()->inverse)
-            {
-                m_app->m_led_controllers[i]->toggle_device();
-            }
+            const RelativeRule rule = { relative_clock::to_nanoseconds(timer_config->start), relative_clock::to_nanoseconds(timer_config->end), timer_config->repeat };
+            schedules[controller] = { controller, rule, timer_config->inverse };
         }
     }
 
-    return true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Only touch the edges of schedules that were added, removed or changed
+        diff_schedules(m_schedules, schedules, [this](TimingWheel<Edge>::Handle handle) { m_edges.cancel(handle); });
+        diff_schedules(m_wall_schedules, wall_schedules, [this](TimingWheel<Edge>::Handle handle) { m_wall_edges.cancel(handle); });
+
+        const nanoseconds now = elapsed();
+        for (const auto& [controller, schedule] : schedules)
+        {
+            ScheduledTimer& scheduled = m_schedules[controller];
+            scheduled.schedule = schedule;
+            start_schedule(scheduled, now);
+        }
+
+        const wall_clock::time_point wall_now = std::chrono::system_clock::now();
+        for (const auto& [controller, schedule] : wall_schedules)
+        {
+            ScheduledWallTimer& scheduled = m_wall_schedules[controller];
+            scheduled.schedule = schedule;
+            start_wall_schedule(scheduled, wall_now);
+        }
+    }
+    m_condition.notify_all();
 }
 
-void Timer::pause(bool pause) 
+void Timer::shutdown()
 {
-    if (pause == m_paused)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_schedules.clear();
+        m_edges.reset(0);
+        m_wall_schedules.clear();
+        m_wall_edges.reset(0);
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+uint64_t Timer::elapsed_ticks()
+{
+    return static_cast<uint64_t>(std::max(elapsed() / TICK, nanoseconds::rep(0)));
+}
+
+Timer::nanoseconds Timer::elapsed()
+{
+    if (m_paused)
+    {
+        return m_paused_elapsed;
+    }
+    return clock::now() - m_start_time;
+}
+
+void Timer::rebuild_edges()
+{
+    m_edges.reset(m_paused ? 0 : elapsed_ticks());
+    if (m_paused || m_stopping)
     {
         return;
     }
 
-    if (pause == false)
+    // Bring every device in line with the current time, then wait for the next edge
+    const nanoseconds now = elapsed();
+    for (auto& [controller, scheduled] : m_schedules)
     {
-        m_start_time = clock::now() - std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(m_delta_time_s));
+        start_schedule(scheduled, now);
     }
+}
 
-    m_paused = pause;
+void Timer::start_schedule(ScheduledTimer& scheduled, nanoseconds now)
+{
+    if (m_paused || m_stopping)
+    {
+        return;
+    }
+    if (now < relative_clock::duration(scheduled.schedule.rule))
+    {
+        scheduled.schedule.controller->apply_timer_state(relative_clock::is_active(scheduled.schedule.rule, now) != scheduled.schedule.inverse);
+    }
+    push_next_edge(scheduled, now);
 }
 
-void Timer::reset()
+void Timer::push_next_edge(ScheduledTimer& scheduled, nanoseconds after)
 {
-    m_delta_time_s = 0.0f;
-    for (size_t i = 1; i < m_app->m_timer_configs.size(); i++)
+    std::optional<nanoseconds> edge = relative_clock::next_transition(scheduled.schedule.rule, after);
+    if (!edge)
     {
-        m_app->m_timer_configs[i]->update_progress(0.0f);
+        return;
     }
 
-    pause(true);
+    const uint64_t due_tick = static_cast<uint64_t>((*edge + TICK - nanoseconds(1)) / TICK); // Rounded up so an edge never fires early
+    const bool device_on = relative_clock::is_active(scheduled.schedule.rule, *edge) != scheduled.schedule.inverse;
+    scheduled.next_edge = m_edges.insert(due_tick, { scheduled.schedule.controller, *edge, device_on });
+}
+
+uint64_t Timer::wall_ticks(wall_clock::time_point time)
+{
+    return static_cast<uint64_t>(std::max<long long>(std::chrono::floor<std::chrono::milliseconds>(time.time_since_epoch()).count(), 0));
+}
+
+void Timer::rebuild_wall_edges(wall_clock::time_point now)
+{
+    m_wall_edges.reset(wall_ticks(now));
+    for (auto& [controller, scheduled] : m_wall_schedules)
+    {
+        start_wall_schedule(scheduled, now);
+    }
+}
+
+void Timer::start_wall_schedule(ScheduledWallTimer& scheduled, wall_clock::time_point now)
+{
+    if (m_stopping)
+    {
+        return;
+    }
+
+    // Only the next occurrence is queued, the one after is computed once it fired
+    const bool device_on = wall_clock::is_active(scheduled.schedule.rule, now) != scheduled.schedule.inverse;
+    scheduled.schedule.controller->apply_timer_state(device_on);
+    if (std::optional<wall_clock::time_point> next = wall_clock::next_transition(scheduled.schedule.rule, now))
+    {
+        const nanoseconds time = std::chrono::duration_cast<nanoseconds>(next->time_since_epoch());
+        const uint64_t due_tick = static_cast<uint64_t>(std::chrono::ceil<std::chrono::milliseconds>(next->time_since_epoch()).count()); // Rounded up so an edge never fires early
+        scheduled.next_edge = m_wall_edges.insert(due_tick, { scheduled.schedule.controller, time, !device_on });
+    }
+}
+
+void Timer::fire_due_edges()
+{
+    if (!m_paused)
+    {
+        m_edges.advance(elapsed_ticks(), [this](Edge edge)
+        {
+            auto scheduled = m_schedules.find(edge.controller);
+            if (scheduled == m_schedules.end())
+            {
+                return;
+            }
+            edge.controller->apply_timer_state(edge.device_on);
+            push_next_edge(scheduled->second, edge.time);
+        });
+    }
+
+    const wall_clock::time_point wall_now = std::chrono::system_clock::now();
+    if (wall_ticks(wall_now) + 1 < m_wall_edges.current_tick())
+    {
+        std::cout << "[Info] System clock went backwards, re-evaluating wall clock timers." << std::endl;
+        rebuild_wall_edges(wall_now);
+        return;
+    }
+    m_wall_edges.advance(wall_ticks(wall_now), [this, wall_now](Edge edge)
+    {
+        auto scheduled = m_wall_schedules.find(edge.controller);
+        if (scheduled != m_wall_schedules.end())
+        {
+            start_wall_schedule(scheduled->second, wall_now); // Evaluated at the current time in case the clock jumped
+        }
+    });
+}
+
+void Timer::scheduler_loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping)
+    {
+        fire_due_edges();
+
+        clock::time_point wake_up = clock::time_point::max();
+        if (!m_paused && !m_edges.empty())
+        {
+            wake_up = m_start_time + TICK * static_cast<nanoseconds::rep>(m_edges.next_event_tick());
+        }
+        if (!m_wall_edges.empty())
+        {
+            const std::chrono::milliseconds until_wall_edge(static_cast<long long>(m_wall_edges.next_event_tick()) - static_cast<long long>(wall_ticks(std::chrono::system_clock::now())));
+            wake_up = std::min(wake_up, clock::now() + std::clamp<clock::duration>(until_wall_edge, clock::duration(0), WALL_CLOCK_RECHECK));
+        }
+
+        if (wake_up == clock::time_point::max())
+        {
+            m_condition.wait(lock);
+        }
+        else
+        {
+            m_condition.wait_until(lock, wake_up);
+        }
+    }
 }
@@ -2,30 +2,111 @@
 
 #include <chrono>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <unordered_map>
 
 #include "timer_configuration.h"
+#include "relative_schedule.h"
+#include "timing_wheel.h"
 
 class App;
+class LEDController;
 
+// Global timer driving all controllers' timer configurations. A scheduler thread sleeps until
+// the next on/off edge of any configuration and fires it, independent of the frame rate.
+// Pending edges live in a timing wheel, so the cost per edge does not grow with the fleet size.
+// Wall clock schedules keep running while the global timer is paused, only their next edge is queued.
 class Timer
 {
 public:
     explicit Timer(App* app);
-	~Timer() = default;
-	
+	~Timer();
+
 	bool update();
 	void pause(bool val);
 	void reset();
+	// Call after timer configurations or their assignment to controllers changed
+	void reschedule();
+	void shutdown();
 
 	inline float get_relative_time() { return m_delta_time_s; }
 	inline bool is_paused() { return m_paused; }
 	inline bool is_active() { return m_delta_time_s > 0.0001f; }
 
 protected:
-	using clock = std::chrono::high_resolution_clock;
+	using clock = std::chrono::steady_clock;
+	using nanoseconds = std::chrono::nanoseconds;
+
+	// Copy of a controller's timer configuration, only used by the scheduler thread
+	struct Schedule
+	{
+		LEDController* controller;
+		RelativeRule rule;
+		bool inverse;
+
+		bool operator==(const Schedule& other) const = default;
+	};
+
+	struct WallSchedule
+	{
+		LEDController* controller;
+		WallClockRule rule;
+		bool inverse;
+
+		bool operator==(const WallSchedule& other) const = default;
+	};
+
+	struct Edge
+	{
+		LEDController* controller = nullptr;
+		nanoseconds time{ 0 };
+		bool device_on = false;
+	};
+
+	struct ScheduledTimer
+	{
+		Schedule schedule;
+		TimingWheel<Edge>::Handle next_edge;
+	};
+
+	struct ScheduledWallTimer
+	{
+		WallSchedule schedule;
+		TimingWheel<Edge>::Handle next_edge;
+	};
+
+	static constexpr nanoseconds TICK = std::chrono::milliseconds(1);
+	static constexpr std::chrono::minutes WALL_CLOCK_RECHECK{ 1 }; // Picks up adjustments of the system clock
+
+
+	// Require m_mutex
+	nanoseconds elapsed();
+	uint64_t elapsed_ticks();
+	void rebuild_edges();
+	void start_schedule(ScheduledTimer& scheduled, nanoseconds now);
+	void push_next_edge(ScheduledTimer& scheduled, nanoseconds after);
+	static uint64_t wall_ticks(wall_clock::time_point time);
+	void rebuild_wall_edges(wall_clock::time_point now);
+	void start_wall_schedule(ScheduledWallTimer& scheduled, wall_clock::time_point now);
+	void fire_due_edges();
+
+	void scheduler_loop();
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::thread m_thread;
+	std::unordered_map<LEDController*, ScheduledTimer> m_schedules;
+	TimingWheel<Edge> m_edges; // At most one pending edge per schedule, ticks counted from m_start_time
+	std::unordered_map<LEDController*, ScheduledWallTimer> m_wall_schedules;
+	TimingWheel<Edge> m_wall_edges; // Ticks counted from the system clock epoch
+	bool m_stopping = false;
 
-	std::chrono::time_point<clock> m_start_time;
-	float m_delta_time_s;
+	clock::time_point m_start_time;
+	nanoseconds m_paused_elapsed; // Elapsed time frozen while paused
+	float m_delta_time_s; // Only for display, refreshed by update()
 	bool m_paused;
 	App* m_app;
-};
\ No newline at end of file
+};
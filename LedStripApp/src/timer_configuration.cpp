@@ -0,0 +1,56 @@
+#include <algorithm>
+
+#include "timer_configuration.h"
+
+const TimerPlot& TimerConfiguration::plot(double x_max)
+{
+    if (m_plot_version != m_version)
+    {
+        rebuild_plot();
+        m_plot_version = m_version;
+    }
+    m_plot.x.back() = x_max; // Only the closing point depends on the axis, a new x_max does not rebuild the rest
+    return m_plot;
+}
+
+void TimerConfiguration::rebuild_plot()
+{
+    m_plot = TimerPlot();
+    const double off = static_cast<double>(inverse);
+    const double on = static_cast<double>(!inverse);
+    const int cycles = std::max(repeat, 0);
+
+    m_plot.x.push_back(0.0);
+    m_plot.y.push_back(off);
+
+    if (cycles <= MAX_PLOT_CYCLES)
+    {
+        m_plot.x.reserve(2 + 4 * cycles);
+        m_plot.y.reserve(2 + 4 * cycles);
+        for (int j = 0; j < cycles; j++)
+        {
+            const double cycle_start = static_cast<double>(j) * end;
+            m_plot.x.insert(m_plot.x.end(), { cycle_start + start, cycle_start + start, cycle_start + end, cycle_start + end });
+            m_plot.y.insert(m_plot.y.end(), { off, on, on, off });
+        }
+    }
+    else
+    {
+        // Every bucket spans several whole cycles, so the state covers the band between its min and max
+        const double total = static_cast<double>(end) * cycles;
+        const int cycles_per_bucket = (cycles + MAX_PLOT_CYCLES - 1) / MAX_PLOT_CYCLES;
+        const double low = start > 0.0f ? std::min(off, on) : on;
+        const double high = start > 0.0f ? std::max(off, on) : on;
+        for (int j = 0; j < cycles; j += cycles_per_bucket)
+        {
+            m_plot.envelope_x.insert(m_plot.envelope_x.end(), { static_cast<double>(j) * end, std::min(static_cast<double>(j + cycles_per_bucket) * end, total) });
+            m_plot.envelope_low.insert(m_plot.envelope_low.end(), { low, low });
+            m_plot.envelope_high.insert(m_plot.envelope_high.end(), { high, high });
+        }
+        m_plot.x.insert(m_plot.x.end(), { static_cast<double>(start), static_cast<double>(start), total, total });
+        m_plot.y.insert(m_plot.y.end(), { off, on, on, off });
+    }
+
+    m_plot.x.push_back(0.0); // Closing point at the end of the axis, set by plot()
+    m_plot.y.push_back(off);
+}
@@ -2,14 +2,41 @@
 
 #include <chrono>
 #include <iostream>
+#include <vector>
+#include <cstdint>
+
+#include "wall_clock_schedule.h"
+#include "slot_map.h"
+
+enum class TimerAnchor
+{
+    RELATIVE = 0,   // Offsets from when the global timer is started
+    WALL_CLOCK = 1  // Daily/weekly rule on local time, runs regardless of the global timer
+};
+
+// Geometry of a configuration in the Live Timer View, in relative seconds
+struct TimerPlot
+{
+    std::vector<double> x; // Step function of the device state
+    std::vector<double> y;
+    std::vector<double> envelope_x; // Min/max band where cycles are too dense to draw one by one
+    std::vector<double> envelope_low;
+    std::vector<double> envelope_high;
+};
 
 class TimerConfiguration
 {
 public:
     explicit TimerConfiguration(std::string name, float start, float end, int repeat, bool inverse)
-        : name(name), start(start), end(end), repeat(repeat), inverse(inverse) {}
+        : name(name), start(start), end(end), repeat(repeat), inverse(inverse), m_version(++s_last_version) {}
 	~TimerConfiguration() = default;
 
+    // Call after editing start, end, repeat, inverse or anchor
+    inline void mark_changed() { m_version = ++s_last_version; }
+    inline uint64_t version() const { return m_version; }
+    static inline uint64_t last_version() { return s_last_version; } // Changes whenever any configuration is created or edited
+    const TimerPlot& plot(double x_max);
+
     inline float get_progress_percentage() { return progress / static_cast<float>(repeat); }
     inline bool is_done() { return progress > static_cast<float>(repeat) || start >= end; }
 
@@ -36,9 +63,25 @@ public:
     float end;
     int repeat;
     bool inverse;
+    TimerAnchor anchor = TimerAnchor::RELATIVE;
+    WallClockRule wall_clock;
+
+    static inline const char* anchor_strings[] = { "Relative", "Wall clock" };
 
 protected:
     float progress = 0.0f; // Range: 0-repeat
 
+private:
+    void rebuild_plot();
+
+    static constexpr int MAX_PLOT_CYCLES = 256; // Above this many cycles the plot shows their envelope
+    static inline uint64_t s_last_version = 0; // Versions are unique across configurations, UI thread only
+
+    uint64_t m_version;
+    uint64_t m_plot_version = 0;
+    TimerPlot m_plot;
+
     friend class Timer;
-};
\ No newline at end of file
+};
+
+using TimerConfigHandle = SlotMap<TimerConfiguration>::Handle;
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+
+// Hierarchical timing wheel keyed by integer ticks. Insert, cancel and fire are O(1) amortized,
+// far away entries sit in coarse levels and cascade down as their time comes closer.
+// Not thread safe, owned by whoever advances it.
+template <typename T>
+class TimingWheel
+{
+public:
+	struct Handle
+	{
+		uint32_t index = NIL;
+		uint32_t generation = 0;
+	};
+
+	explicit TimingWheel(uint64_t now_tick = 0) : m_current(now_tick)
+	{
+		for (auto& level : m_heads)
+		{
+			level.fill(NIL);
+		}
+	}
+	~TimingWheel() = default;
+
+	inline size_t size() const { return m_size; }
+	inline bool empty() const { return m_size == 0; }
+	inline uint64_t current_tick() const { return m_current; }
+
+	// Entries due before the current tick fire on the next advance
+	Handle insert(uint64_t due_tick, T value)
+	{
+		uint32_t index;
+		if (m_free != NIL)
+		{
+			index = m_free;
+			m_free = m_entries[index].next;
+		}
+		else
+		{
+			index = static_cast<uint32_t>(m_entries.size());
+			m_entries.emplace_back();
+		}
+
+		Entry& entry = m_entries[index];
+		entry.value = std::move(value);
+		entry.due = std::max(due_tick, m_current);
+		entry.alive = true;
+		link(index);
+		m_size++;
+		return { index, entry.generation };
+	}
+
+	// Returns false if the entry already fired or was cancelled
+	bool cancel(Handle handle)
+	{
+		if (!is_pending(handle))
+		{
+			return false;
+		}
+		unlink(handle.index);
+		release(handle.index);
+		return true;
+	}
+
+	inline bool is_pending(Handle handle) const
+	{
+		return handle.index < m_entries.size() && m_entries[handle.index].alive && m_entries[handle.index].generation == handle.generation;
+	}
+
+	// Drops all entries and restarts counting at now_tick
+	void reset(uint64_t now_tick)
+	{
+		for (uint32_t i = 0; i < m_entries.size(); i++)
+		{
+			if (m_entries[i].alive)
+			{
+				release(i);
+			}
+		}
+		for (auto& level : m_heads)
+		{
+			level.fill(NIL);
+		}
+		m_occupied.fill(0);
+		m_current = now_tick;
+	}
+
+	// Earliest tick at which advance has work to do, either firing or cascading. Never later than
+	// the earliest due entry, so it is safe to sleep until then.
+	uint64_t next_event_tick() const
+	{
+		uint64_t next = UINT64_MAX;
+		for (size_t level = 0; level < LEVELS; level++)
+		{
+			if (m_occupied[level] == 0)
+			{
+				continue;
+			}
+			const unsigned shift = static_cast<unsigned>(level * SLOT_BITS);
+			const uint64_t unit = uint64_t(1) << shift;
+			const uint64_t first_index = level == 0 ? m_current : (m_current + unit - 1) >> shift;
+			const uint64_t offset = std::countr_zero(std::rotr(m_occupied[level], static_cast<int>(first_index & SLOT_MASK)));
+			next = std::min(next, (first_index + offset) << shift);
+		}
+		return next;
+	}
+
+	// Fires every entry due at or before now_tick in order of due tick. fire may insert and cancel.
+	template <typename F>
+	void advance(uint64_t now_tick, F&& fire)
+	{
+		while (!empty())
+		{
+			const uint64_t tick = next_event_tick();
+			if (tick > now_tick)
+			{
+				break;
+			}
+			m_current = tick;
+
+			// Coarse levels first so their entries can land in the finer slots handled right after
+			for (size_t level = LEVELS - 1; level > 0; level--)
+			{
+				const unsigned shift = static_cast<unsigned>(level * SLOT_BITS);
+				if ((tick & ((uint64_t(1) << shift) - 1)) == 0)
+				{
+					cascade(level, (tick >> shift) & SLOT_MASK);
+				}
+			}
+
+			uint32_t index = take_slot(0, tick & SLOT_MASK);
+			m_current = tick + 1; // Entries inserted while firing go to later ticks
+			m_firing.clear();
+			for (; index != NIL; index = m_entries[index].next)
+			{
+				m_firing.push_back({ index, m_entries[index].generation });
+			}
+			for (const Handle& handle : m_firing)
+			{
+				if (!is_pending(handle))
+				{
+					continue; // Cancelled by an earlier callback
+				}
+				T value = std::move(m_entries[handle.index].value);
+				release(handle.index);
+				fire(std::move(value));
+			}
+		}
+		m_current = std::max(m_current, now_tick + 1);
+	}
+
+private:
+	static constexpr uint32_t NIL = UINT32_MAX;
+	static constexpr size_t SLOT_BITS = 6;
+	static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+	static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+	static constexpr size_t LEVELS = 4; // 2^24 ticks, about 4.6 hours at 1 ms
+	static constexpr uint64_t RANGE = uint64_t(1) << (SLOT_BITS * LEVELS);
+
+	struct Entry
+	{
+		T value{};
+		uint64_t due = 0;
+		uint32_t prev = NIL;
+		uint32_t next = NIL;
+		uint32_t generation = 0;
+		uint8_t level = 0;
+		uint8_t slot = 0;
+		bool alive = false;
+		bool linked = false;
+	};
+
+	void link(uint32_t index)
+	{
+		Entry& entry = m_entries[index];
+		// Beyond the range entries park in the top level and get re-linked when it cascades
+		const uint64_t due = std::min(entry.due, m_current + RANGE - 1);
+		const uint64_t delta = due - m_current;
+
+		size_t level = 0;
+		while (level + 1 < LEVELS && delta >= (uint64_t(1) << ((level + 1) * SLOT_BITS)))
+		{
+			level++;
+		}
+		const size_t slot = (due >> (level * SLOT_BITS)) & SLOT_MASK;
+
+		uint32_t& head = m_heads[level][slot];
+		entry.level = static_cast<uint8_t>(level);
+		entry.slot = static_cast<uint8_t>(slot);
+		entry.prev = NIL;
+		entry.next = head;
+		if (head != NIL)
+		{
+			m_entries[head].prev = index;
+		}
+		head = index;
+		entry.linked = true;
+		m_occupied[level] |= uint64_t(1) << slot;
+	}
+
+	void unlink(uint32_t index)
+	{
+		Entry& entry = m_entries[index];
+		if (!entry.linked)
+		{
+			return; // Taken out of its slot to fire
+		}
+		if (entry.prev != NIL)
+		{
+			m_entries[entry.prev].next = entry.next;
+		}
+		else
+		{
+			m_heads[entry.level][entry.slot] = entry.next;
+			if (entry.next == NIL)
+			{
+				m_occupied[entry.level] &= ~(uint64_t(1) << entry.slot);
+			}
+		}
+		if (entry.next != NIL)
+		{
+			m_entries[entry.next].prev = entry.prev;
+		}
+		entry.linked = false;
+	}
+
+	// Detaches the whole slot, the returned list stays walkable through next
+	uint32_t take_slot(size_t level, size_t slot)
+	{
+		const uint32_t head = m_heads[level][slot];
+		m_heads[level][slot] = NIL;
+		m_occupied[level] &= ~(uint64_t(1) << slot);
+		for (uint32_t index = head; index != NIL; index = m_entries[index].next)
+		{
+			m_entries[index].linked = false;
+		}
+		return head;
+	}
+
+	void cascade(size_t level, size_t slot)
+	{
+		uint32_t index = take_slot(level, slot);
+		while (index != NIL)
+		{
+			const uint32_t next = m_entries[index].next;
+			link(index);
+			index = next;
+		}
+	}
+
+	void release(uint32_t index)
+	{
+		Entry& entry = m_entries[index];
+		entry.value = T{};
+		entry.alive = false;
+		entry.linked = false;
+		entry.generation++;
+		entry.next = m_free;
+		m_free = index;
+		m_size--;
+	}
+
+private:
+	std::vector<Entry> m_entries;
+	uint32_t m_free = NIL;
+	size_t m_size = 0;
+	uint64_t m_current; // All ticks before this one have been processed
+	std::array<std::array<uint32_t, SLOTS>, LEVELS> m_heads;
+	std::array<uint64_t, LEVELS> m_occupied{};
+	std::vector<Handle> m_firing;
+};
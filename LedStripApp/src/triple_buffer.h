@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer/single consumer channel that always hands the latest written value
+// to the reader. Writer and reader each own one of three slots, the third is swapped atomically.
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+	~TripleBuffer() = default;
+
+	// Producer side only
+	void write(const T& value)
+	{
+		m_buffers[m_back] = value;
+		m_back = m_middle.exchange(m_back | DIRTY, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// Consumer side only, returns the newest value written so far (default constructed before the first write)
+	const T& read()
+	{
+		if (m_middle.load(std::memory_order_relaxed) & DIRTY)
+		{
+			m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+		}
+		return m_buffers[m_front];
+	}
+
+private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t DIRTY = 0x4;
+
+	std::array<T, 3> m_buffers{};
+	alignas(64) uint8_t m_back = 0;
+	alignas(64) std::atomic<uint8_t> m_middle = 1;
+	alignas(64) uint8_t m_front = 2;
+};
@@ -0,0 +1,159 @@
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+#include "wall_clock_schedule.h"
+
+namespace
+{
+    // Mid-month sunrise and sunset in local standard time, minutes after midnight
+    struct SunTimes
+    {
+        int sunrise;
+        int sunset;
+    };
+
+    constexpr std::array<SunTimes, 12> SUN_TABLE = { {
+        { 8 * 60 + 30, 16 * 60 + 5 },  // January
+        { 7 * 60 + 40, 17 * 60 + 5 },  // February
+        { 6 * 60 + 30, 18 * 60 + 0 },  // March
+        { 5 * 60 + 15, 19 * 60 + 0 },  // April
+        { 4 * 60 + 15, 20 * 60 + 0 },  // May
+        { 3 * 60 + 25, 20 * 60 + 55 }, // June
+        { 3 * 60 + 45, 20 * 60 + 45 }, // July
+        { 4 * 60 + 45, 19 * 60 + 45 }, // August
+        { 5 * 60 + 50, 18 * 60 + 25 }, // September
+        { 6 * 60 + 55, 17 * 60 + 5 },  // October
+        { 7 * 60 + 55, 16 * 60 + 0 },  // November
+        { 8 * 60 + 35, 15 * 60 + 35 }  // December
+    } };
+
+    // How far the interval of one day can reach into the following ones, offsets are at most a day
+    constexpr int LOOKBEHIND_DAYS = 3;
+    constexpr int LOOKAHEAD_DAYS = 8;
+
+    int interpolate(std::chrono::local_days day, int SunTimes::* field)
+    {
+        const std::chrono::year_month_day date{ day };
+        const int month = static_cast<int>(static_cast<unsigned>(date.month())) - 1;
+        const int days_in_month = static_cast<int>(static_cast<unsigned>((date.year() / date.month() / std::chrono::last).day()));
+        const double position = month + (static_cast<int>(static_cast<unsigned>(date.day())) - 15.0) / days_in_month;
+
+        const double lower = std::floor(position);
+        const double fraction = position - lower;
+        const SunTimes& from = SUN_TABLE[(static_cast<int>(lower) + 12) % 12];
+        const SunTimes& to = SUN_TABLE[(static_cast<int>(lower) + 13) % 12];
+        return static_cast<int>(std::lround(from.*field * (1.0 - fraction) + to.*field * fraction));
+    }
+
+    // Daylight saving offset in effect on the given local day
+    int daylight_saving_minutes(std::chrono::local_days day)
+    {
+        const std::chrono::time_zone* zone = std::chrono::current_zone();
+        const std::chrono::sys_info info = zone->get_info(zone->to_sys(day + std::chrono::hours(12), std::chrono::choose::earliest));
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::minutes>(info.save).count());
+    }
+
+    wall_clock::time_point resolve(const TimeOfDay& time, std::chrono::local_days day)
+    {
+        int minutes = time.offset_minutes;
+        if (time.reference == TimeReference::SUNRISE)
+        {
+            minutes += wall_clock::sunrise_minutes(day);
+        }
+        else if (time.reference == TimeReference::SUNSET)
+        {
+            minutes += wall_clock::sunset_minutes(day);
+        }
+
+        const std::chrono::local_time<std::chrono::minutes> local = day + std::chrono::minutes(minutes);
+        return std::chrono::current_zone()->to_sys(local, std::chrono::choose::earliest);
+    }
+
+    bool runs_on(const WallClockRule& rule, std::chrono::local_days day)
+    {
+        const unsigned monday_based = (std::chrono::weekday{ day }.c_encoding() + 6) % 7;
+        return (rule.weekdays & (1u << monday_based)) != 0;
+    }
+
+    struct Interval
+    {
+        wall_clock::time_point on;
+        wall_clock::time_point off;
+    };
+
+    std::optional<Interval> interval(const WallClockRule& rule, std::chrono::local_days day)
+    {
+        if (!runs_on(rule, day))
+        {
+            return std::nullopt;
+        }
+
+        const wall_clock::time_point on = resolve(rule.on, day);
+        wall_clock::time_point off = resolve(rule.off, day);
+        if (off <= on)
+        {
+            off = resolve(rule.off, day + std::chrono::days(1));
+        }
+        if (off <= on)
+        {
+            return std::nullopt;
+        }
+        return Interval{ on, off };
+    }
+
+    std::chrono::local_days local_day(wall_clock::time_point time)
+    {
+        return std::chrono::floor<std::chrono::days>(std::chrono::current_zone()->to_local(time));
+    }
+}
+
+namespace wall_clock
+{
+    bool is_active(const WallClockRule& rule, time_point time)
+    {
+        const std::chrono::local_days today = local_day(time);
+        for (int i = -LOOKBEHIND_DAYS; i <= 0; i++)
+        {
+            std::optional<Interval> active = interval(rule, today + std::chrono::days(i));
+            if (active && active->on <= time && time < active->off)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::optional<time_point> next_transition(const WallClockRule& rule, time_point after)
+    {
+        std::optional<time_point> next;
+        auto consider = [&next, after](time_point candidate)
+        {
+            if (candidate > after && (!next || candidate < *next))
+            {
+                next = candidate;
+            }
+        };
+
+        const std::chrono::local_days today = local_day(after);
+        for (int i = -LOOKBEHIND_DAYS; i <= LOOKAHEAD_DAYS; i++)
+        {
+            if (std::optional<Interval> active = interval(rule, today + std::chrono::days(i)))
+            {
+                consider(active->on);
+                consider(active->off);
+            }
+        }
+        return next;
+    }
+
+    int sunrise_minutes(std::chrono::local_days day)
+    {
+        return interpolate(day, &SunTimes::sunrise) + daylight_saving_minutes(day);
+    }
+
+    int sunset_minutes(std::chrono::local_days day)
+    {
+        return interpolate(day, &SunTimes::sunset) + daylight_saving_minutes(day);
+    }
+}
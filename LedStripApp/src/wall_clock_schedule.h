@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <cstdint>
+
+// Point in the local day a wall clock schedule switches at
+enum class TimeReference
+{
+	MIDNIGHT = 0,
+	SUNRISE = 1,
+	SUNSET = 2
+};
+
+struct TimeOfDay
+{
+	TimeReference reference = TimeReference::MIDNIGHT;
+	int offset_minutes = 0; // Relative to the reference, may be negative
+
+	bool operator==(const TimeOfDay& other) const = default;
+
+	static inline const char* reference_strings[] = { "Midnight", "Sunrise", "Sunset" };
+};
+
+// Daily/weekly rule anchored to local wall clock time. The device is active from `on` until the
+// following `off` on every selected weekday, an `off` before `on` ends the interval the next day.
+struct WallClockRule
+{
+	TimeOfDay on = { TimeReference::MIDNIGHT, 18 * 60 };
+	TimeOfDay off = { TimeReference::MIDNIGHT, 23 * 60 };
+	uint8_t weekdays = ALL_WEEKDAYS; // Bit 0 is Monday
+
+	bool operator==(const WallClockRule& other) const = default;
+
+	static constexpr uint8_t ALL_WEEKDAYS = 0x7F;
+	static inline const char* weekday_strings[] = { "Mo", "Tu", "We", "Th", "Fr", "Sa", "Su" };
+};
+
+namespace wall_clock
+{
+	using time_point = std::chrono::system_clock::time_point;
+
+	// Both only look at the days around the given time, nothing is materialized ahead
+	bool is_active(const WallClockRule& rule, time_point time);
+	std::optional<time_point> next_transition(const WallClockRule& rule, time_point after);
+
+	// Minutes after local midnight, interpolated from a fixed table for 55.7 N, 12.6 E
+	int sunrise_minutes(std::chrono::local_days day);
+	int sunset_minutes(std::chrono::local_days day);
+}
@@ -0,0 +1,147 @@
+// Times encoding one animation frame for many controllers through ColorBatch, with the SIMD kernels
+// and with the scalar reference path, against calling color_pipeline::encode once per controller as
+// single updates do. The same for temporally dithered frames, which carry their error from frame to
+// frame. Checks that all paths produce the same payloads.
+//
+// Not part of LedStripApp.vcxproj, build it from LedStripApp/src:
+//   cl /std:c++20 /EHsc /O2 /I. ..\tools\color_bench.cpp color_pipeline.cpp
+//   g++ -std=c++20 -O2 -I. ../tools/color_bench.cpp color_pipeline.cpp
+//
+// Usage: color_bench [controllers...], default 16 100 1000 10000
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+#include "color_pipeline.h"
+
+namespace
+{
+    constexpr int FRAMES = 1000;
+
+    struct Frame
+    {
+        std::vector<std::array<float, 3>> colors;
+        std::vector<float> brightness;
+        std::vector<ColorCurve> curves;
+    };
+
+    Frame generate(size_t count)
+    {
+        std::mt19937 rng(static_cast<uint32_t>(count));
+        std::uniform_real_distribution<float> level(0.0f, 1.0f);
+        Frame frame;
+        for (size_t i = 0; i < count; i++)
+        {
+            frame.colors.push_back({ level(rng), level(rng), level(rng) });
+            frame.brightness.push_back(level(rng));
+            frame.curves.push_back(static_cast<ColorCurve>(i % 3));
+        }
+        return frame;
+    }
+
+    // Nanoseconds per controller and frame
+    template <typename Function>
+    double time_per_entry(size_t count, Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < FRAMES; frame++)
+        {
+            function();
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (static_cast<double>(FRAMES) * static_cast<double>(count));
+    }
+
+    bool run(size_t count)
+    {
+        const Frame frame = generate(count);
+        ColorBatch batch;
+        std::vector<ColorPayload> batched;
+        std::vector<ColorPayload> batched_scalar;
+        std::vector<ColorPayload> single(count);
+
+        // Filling the batch is part of every frame, as in the animation player
+        auto fill = [&]() {
+            batch.resize(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                batch.set(i, frame.colors[i], frame.brightness[i], frame.curves[i]);
+            }
+        };
+        const double batch_time = time_per_entry(count, [&]() { fill(); batch.encode(batched); });
+        const double scalar_time = time_per_entry(count, [&]() { fill(); batch.encode_scalar(batched_scalar); });
+        const double single_time = time_per_entry(count, [&]() {
+            for (size_t i = 0; i < count; i++)
+            {
+                single[i] = color_pipeline::encode(frame.colors[i], frame.brightness[i], frame.curves[i]);
+            }
+        });
+
+        std::cout << count << " controllers: batch " << batch_time << " ns, batch scalar " << scalar_time
+            << " ns, color_pipeline::encode " << single_time << " ns per controller" << std::endl;
+        if (batched != single || batched_scalar != single)
+        {
+            std::cout << "Batch payloads differ from color_pipeline::encode." << std::endl;
+            return false;
+        }
+
+        // Every path runs the same number of frames, so the errors carried between them line up
+        std::vector<DitherError> errors(count, DitherError{});
+        batch.reset_dither();
+        const double dithered_time = time_per_entry(count, [&]() {
+            for (size_t i = 0; i < count; i++)
+            {
+                batch.set(i, frame.colors[i], frame.brightness[i], frame.curves[i]);
+            }
+            batch.encode_dithered(batched);
+        });
+        const double single_dithered_time = time_per_entry(count, [&]() {
+            for (size_t i = 0; i < count; i++)
+            {
+                single[i] = color_pipeline::encode_dithered(frame.colors[i], frame.brightness[i], frame.curves[i], errors[i]);
+            }
+        });
+
+        std::cout << count << " controllers dithered: batch " << dithered_time << " ns, color_pipeline::encode_dithered "
+            << single_dithered_time << " ns per controller" << std::endl;
+        if (batched != single)
+        {
+            std::cout << "Dithered batch payloads differ from color_pipeline::encode_dithered." << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            if (batch.error(i) != errors[i])
+            {
+                std::cout << "Dither errors of the batch differ from color_pipeline::encode_dithered." << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++)
+    {
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (counts.empty())
+    {
+        counts = { 16, 100, 1000, 10000 };
+    }
+
+    bool matched = true;
+    for (size_t count : counts)
+    {
+        matched = run(count) && matched;
+    }
+    return matched ? EXIT_SUCCESS : EXIT_FAILURE;
+}
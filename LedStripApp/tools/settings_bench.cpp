@@ -0,0 +1,152 @@
+// Times loading generated settings from settings.bin and from settings.yaml, the two forms the app
+// starts from. The files are written by SettingsWriter into a temporary directory, as the app does.
+// Then times a round trip through settings_yaml::write and read_document in memory, and checks that
+// the settings read back emit the same YAML again.
+//
+// Not part of LedStripApp.vcxproj, build it from LedStripApp/src:
+//   cl /std:c++20 /EHsc /O2 /DYAML_CPP_STATIC_DEFINE /I. ..\tools\settings_bench.cpp settings_snapshot.cpp
+//      settings_binary.cpp durable_file.cpp color_pipeline.cpp ..\lib\yaml-cpp.lib
+//   g++ -std=c++20 -O2 -I. ../tools/settings_bench.cpp settings_snapshot.cpp settings_binary.cpp
+//      durable_file.cpp color_pipeline.cpp -lyaml-cpp -pthread
+//
+// Usage: settings_bench [entries...], controllers, LED configs and timer configs each, default 1000 10000 100000
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <cstdlib>
+
+#include "settings_snapshot.h"
+#include "settings_binary.h"
+
+namespace
+{
+    SettingsSnapshot generate(size_t count)
+    {
+        SettingsSnapshot snapshot;
+        for (size_t i = 0; i < count; i++)
+        {
+            const std::string suffix = std::to_string(i);
+            const float level = static_cast<float>(i % 256) / 255.0f;
+            snapshot.controllers.push_back({ "SIM-" + suffix, static_cast<int>(i % count) + 1, static_cast<int>((i * 7) % count) + 1,
+                i % 2 == 0, i % 3 != 0, 10.0f + static_cast<float>(i % 50), i % 5 != 0 });
+
+            LEDConfiguration& config = snapshot.led_configs.emplace_back("Scene " + suffix, i % 2 == 1,
+                std::array<float, 3>{ level, 1.0f - level, 0.5f }, 0.25f + 0.75f * level, Mode(static_cast<int>(i % 21), 0.5f));
+            config.curve = static_cast<ColorCurve>(i % 3);
+
+            TimerSettings& timer = snapshot.timer_configs.emplace_back();
+            timer.name = "Schedule " + suffix;
+            timer.start = static_cast<float>(i % 60);
+            timer.end = timer.start + 1.0f + static_cast<float>(i % 30);
+            timer.repeat = 1 + static_cast<int>(i % 10);
+            timer.inverse = i % 4 == 0;
+            timer.anchor = i % 2 == 0 ? TimerAnchor::RELATIVE : TimerAnchor::WALL_CLOCK;
+            timer.wall_clock.on.offset_minutes = static_cast<int>(i % 120) - 60;
+            timer.wall_clock.off.offset_minutes = static_cast<int>(i % 90);
+            timer.wall_clock.weekdays = static_cast<uint8_t>(i % 128);
+        }
+        for (size_t group = 0; group < count / 100; group++)
+        {
+            ControllerGroup& entry = snapshot.groups.emplace_back();
+            entry.name = "Group " + std::to_string(group);
+            for (size_t member = group * 100; member < group * 100 + 10; member++)
+            {
+                entry.members.push_back(snapshot.controllers[member].name);
+            }
+        }
+        return snapshot;
+    }
+
+    bool same_shape(const SettingsSnapshot& a, const SettingsSnapshot& b)
+    {
+        return a.controllers.size() == b.controllers.size() && a.led_configs.size() == b.led_configs.size()
+            && a.timer_configs.size() == b.timer_configs.size() && a.groups.size() == b.groups.size()
+            && (a.controllers.empty() || a.controllers.back().name == b.controllers.back().name)
+            && (a.led_configs.empty() || a.led_configs.back().name == b.led_configs.back().name)
+            && (a.timer_configs.empty() || a.timer_configs.back().name == b.timer_configs.back().name);
+    }
+
+    std::string emit(const SettingsSnapshot& snapshot)
+    {
+        YAML::Emitter out;
+        settings_yaml::write(out, snapshot);
+        return out.c_str();
+    }
+
+    template <typename Function>
+    double milliseconds(Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool run(size_t count, const std::filesystem::path& directory)
+    {
+        const SettingsSnapshot generated = generate(count);
+        {
+            SettingsWriter writer;
+            writer.open(directory);
+            writer.write(generated);
+            writer.wait();
+        }
+
+        SettingsSnapshot from_binary;
+        const double binary_time = milliseconds([&]() { from_binary = SettingsImage::read(directory / "settings.bin")->snapshot(); });
+
+        SettingsSnapshot from_yaml;
+        const double yaml_time = milliseconds([&]() {
+            std::ifstream file(directory / "settings.yaml");
+            from_yaml = settings_yaml::read_document(YAML::Load(file));
+        });
+
+        std::cout << count << " entries each: settings.bin " << std::filesystem::file_size(directory / "settings.bin") / 1024 << " KiB loaded in "
+            << binary_time << " ms, settings.yaml " << std::filesystem::file_size(directory / "settings.yaml") / 1024 << " KiB loaded in "
+            << yaml_time << " ms" << std::endl;
+        if (!same_shape(generated, from_binary) || !same_shape(generated, from_yaml))
+        {
+            std::cout << "Loaded settings differ from the generated ones." << std::endl;
+            return false;
+        }
+
+        std::string text;
+        const double save_time = milliseconds([&]() { text = emit(generated); });
+        SettingsSnapshot round_trip;
+        const double load_time = milliseconds([&]() { round_trip = settings_yaml::read_document(YAML::Load(text)); });
+        std::cout << count << " entries each: YAML round trip saved in " << save_time << " ms, loaded in " << load_time << " ms" << std::endl;
+        if (emit(round_trip) != text)
+        {
+            std::cout << "Settings read back from YAML differ from the saved ones." << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++)
+    {
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (counts.empty())
+    {
+        counts = { 1000, 10000, 100000 };
+    }
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "settings_bench";
+    bool matched = true;
+    for (size_t count : counts)
+    {
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        matched = run(count, directory) && matched;
+    }
+    std::filesystem::remove_all(directory);
+    return matched ? EXIT_SUCCESS : EXIT_FAILURE;
+}
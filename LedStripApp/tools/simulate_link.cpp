@@ -0,0 +1,177 @@
+// Headless run of simulated devices through the bluetooth scheduler, without the app, its window or a
+// bluetooth stack. Every device streams colors on its own strand the way an animation does, with
+// every n-th write acknowledged, and reconnects when the link drops. Prints what each device ended
+// up showing and how its link behaved.
+//
+// Not part of LedStripApp.vcxproj, build it from LedStripApp/src:
+//   cl /std:c++20 /EHsc /O2 /I. ..\tools\simulate_link.cpp ble_scheduler.cpp simulated_peripheral.cpp
+//   g++ -std=c++20 -O2 -I. ../tools/simulate_link.cpp ble_scheduler.cpp simulated_peripheral.cpp -pthread
+//
+// Usage: simulate_link [devices] [seconds] [options]
+// Options are those of the app's --simulate=, e.g. simulate_link 4 10 loss=0.05,disconnect=0.01,seed=7
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+#include "ble_scheduler.h"
+#include "simulated_peripheral.h"
+
+namespace
+{
+    constexpr std::chrono::milliseconds FRAME_INTERVAL{ 33 }; // 30 Hz, the default max command rate
+    constexpr std::chrono::milliseconds RECONNECT_DELAY{ 500 };
+    constexpr int SYNC_INTERVAL = 8; // Every n-th streamed write is acknowledged
+
+    struct Device
+    {
+        std::unique_ptr<SimulatedPeripheral> peripheral;
+        std::shared_ptr<BLEScheduler::Strand> strand;
+        uint64_t frame = 0; // Only touched from the strand
+        uint64_t failed_writes = 0;
+        uint64_t reconnects = 0;
+        std::mutex mutex;
+        SimulatedDeviceState last_sent; // Last color whose write did not fail
+    };
+
+    class Simulation
+    {
+    public:
+        Simulation(size_t device_count, const SimulationProfile& profile)
+        {
+            for (size_t i = 0; i < device_count; i++)
+            {
+                SimulationProfile device_profile = profile;
+                device_profile.seed += static_cast<uint32_t>(i); // Distinct but repeatable per device
+                std::unique_ptr<Device> device = std::make_unique<Device>();
+                device->peripheral = std::make_unique<SimulatedPeripheral>(SimulatedPeripheral::IDENTIFIER_PREFIX + std::to_string(i), device_profile);
+                device->strand = m_scheduler.make_strand();
+                m_devices.push_back(std::move(device));
+            }
+        }
+
+        void run(std::chrono::seconds duration)
+        {
+            for (const std::unique_ptr<Device>& device : m_devices)
+            {
+                Device* target = device.get();
+                m_scheduler.submit(target->strand, [this, target]() { connect(*target); }, BLEScheduler::Lane::BLOCKING);
+            }
+            std::this_thread::sleep_for(duration);
+            m_stopping = true;
+            for (const std::unique_ptr<Device>& device : m_devices)
+            {
+                m_scheduler.close(device->strand);
+            }
+        }
+
+        void report()
+        {
+            SimulationStats total;
+            size_t in_sync = 0;
+            for (const std::unique_ptr<Device>& device : m_devices)
+            {
+                const SimulationStats stats = device->peripheral->stats();
+                const SimulatedDeviceState shown = device->peripheral->state();
+                std::lock_guard<std::mutex> lock(device->mutex);
+                const bool synced = shown.red == device->last_sent.red && shown.green == device->last_sent.green && shown.blue == device->last_sent.blue;
+                in_sync += synced ? 1 : 0;
+                std::cout << device->peripheral->identifier() << ": " << device->frame << " frames, "
+                    << stats.acknowledged_writes << " acknowledged, " << stats.unacknowledged_writes << " unacknowledged, "
+                    << stats.lost_writes << " lost, " << device->failed_writes << " failed, "
+                    << stats.disconnects << " disconnects, " << device->reconnects << " reconnects, "
+                    << (synced ? "showing the last color" : "behind the last color") << std::endl;
+
+                total.acknowledged_writes += stats.acknowledged_writes;
+                total.unacknowledged_writes += stats.unacknowledged_writes;
+                total.lost_writes += stats.lost_writes;
+                total.disconnects += stats.disconnects;
+            }
+            std::cout << "Total: " << total.acknowledged_writes << " acknowledged, " << total.unacknowledged_writes << " unacknowledged, "
+                << total.lost_writes << " lost, " << total.disconnects << " disconnects, "
+                << in_sync << "/" << m_devices.size() << " devices showing their last color" << std::endl;
+        }
+
+    private:
+        void connect(Device& device)
+        {
+            if (m_stopping)
+            {
+                return;
+            }
+            device.peripheral->connect();
+            m_scheduler.submit(device.strand, [this, &device]() { tick(device); });
+        }
+
+        void tick(Device& device)
+        {
+            if (m_stopping)
+            {
+                return;
+            }
+
+            // Slow hue sweep, every frame differs from the last one
+            const uint64_t frame = device.frame++;
+            SimulatedDeviceState color;
+            color.red = static_cast<uint8_t>(frame * 3);
+            color.green = static_cast<uint8_t>(frame * 5 + 85);
+            color.blue = static_cast<uint8_t>(frame * 7 + 170);
+            const SimpleBLE::ByteArray command = { (char)0x56, (char)color.red, (char)color.green, (char)color.blue, (char)0x00, (char)0xF0, (char)0xAA };
+
+            try
+            {
+                if (device.peripheral->can_write_command("", "") && frame % SYNC_INTERVAL != 0)
+                {
+                    device.peripheral->write_command("", "", command);
+                }
+                else
+                {
+                    device.peripheral->write_request("", "", command);
+                }
+                std::lock_guard<std::mutex> lock(device.mutex);
+                device.last_sent = color;
+            }
+            catch (const TransportError&)
+            {
+                device.failed_writes++;
+                if (!device.peripheral->is_connected())
+                {
+                    device.reconnects++;
+                    m_scheduler.submit_after(device.strand, RECONNECT_DELAY, [this, &device]() { connect(device); }, BLEScheduler::Lane::BLOCKING);
+                    return;
+                }
+            }
+            m_scheduler.submit_after(device.strand, FRAME_INTERVAL, [this, &device]() { tick(device); });
+        }
+
+    private:
+        BLEScheduler m_scheduler;
+        std::vector<std::unique_ptr<Device>> m_devices;
+        std::atomic_bool m_stopping = false;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const size_t device_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+    const std::chrono::seconds duration(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10);
+    const std::optional<SimulationProfile> profile = SimulationProfile::parse(argc > 3 ? argv[3] : "");
+    if (!profile || device_count == 0)
+    {
+        std::cout << "Usage: simulate_link [devices] [seconds] [options]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Simulating " << device_count << " devices for " << duration.count() << " s with loss rate " << profile->loss_rate
+        << ", disconnect rate " << profile->disconnect_rate << " and seed " << profile->seed << "." << std::endl;
+    Simulation simulation(device_count, *profile);
+    simulation.run(duration);
+    simulation.report();
+    return EXIT_SUCCESS;
+}
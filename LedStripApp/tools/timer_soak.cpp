@@ -0,0 +1,108 @@
+// Runs relative timer schedules over weeks of simulated uptime and checks that they do not drift.
+// A synthetic clock steps forward the way the timer's scheduler thread wakes up: at the 1 ms tick
+// after each edge plus some lateness. The next edge is computed from the fired edge, as the timer does,
+// and every so often from the clock reading, as after a reschedule. Every edge must land exactly on
+// k * period or k * period + start, and the device state must flip at every edge and nowhere else.
+//
+// Not part of LedStripApp.vcxproj, build it from LedStripApp/src:
+//   cl /std:c++20 /EHsc /O2 /I. ..\tools\timer_soak.cpp relative_schedule.cpp
+//   g++ -std=c++20 -O2 -I. ../tools/timer_soak.cpp relative_schedule.cpp
+//
+// Usage: timer_soak [weeks], default 6
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <limits>
+#include <optional>
+#include <cmath>
+#include <cstdlib>
+
+#include "relative_schedule.h"
+
+namespace
+{
+    using nanoseconds = std::chrono::nanoseconds;
+
+    constexpr nanoseconds TICK = std::chrono::milliseconds(1); // As the timer's timing wheel
+    constexpr nanoseconds MAX_LATENESS = std::chrono::milliseconds(20); // Scheduler thread waking late
+    constexpr uint64_t RESCHEDULE_INTERVAL = 16; // Edges between reschedules
+
+    struct Configuration
+    {
+        float start; // Seconds, as entered in the UI
+        float end;
+    };
+
+    bool soak(const Configuration& configuration, nanoseconds uptime, std::mt19937& rng)
+    {
+        RelativeRule rule = { relative_clock::to_nanoseconds(configuration.start), relative_clock::to_nanoseconds(configuration.end) };
+        rule.repeat = static_cast<int>(uptime / rule.period) + 1; // Outlasts the soak
+        std::uniform_int_distribution<nanoseconds::rep> lateness(0, MAX_LATENESS.count());
+
+        uint64_t edges = 0;
+        uint64_t errors = 0;
+        bool device_on = relative_clock::is_active(rule, nanoseconds(0));
+        std::optional<nanoseconds> edge = relative_clock::next_transition(rule, nanoseconds(0));
+        while (edge && *edge <= uptime)
+        {
+            // The clock reads the edge's tick plus the scheduler's lateness, the edge itself stays exact
+            const nanoseconds due = (*edge + TICK - nanoseconds(1)) / TICK * TICK;
+            const nanoseconds now = due + nanoseconds(lateness(rng));
+
+            const nanoseconds::rep k = *edge / rule.period;
+            const bool on_start = *edge == k * rule.period + rule.start;
+            const bool on_end = *edge == k * rule.period;
+            const bool flipped = relative_clock::is_active(rule, *edge) != device_on
+                && relative_clock::is_active(rule, *edge - nanoseconds(1)) == device_on;
+            if (!(on_start || on_end) || !flipped)
+            {
+                if (errors++ == 0)
+                {
+                    std::cout << "Edge " << edges << " at " << edge->count() << " ns is off the k * period + start grid." << std::endl;
+                }
+            }
+
+            device_on = !device_on;
+            edges++;
+            edge = relative_clock::next_transition(rule, edges % RESCHEDULE_INTERVAL == 0 ? now : *edge);
+        }
+
+        // The float seconds the timer used to keep would be this coarse by the end of the soak
+        const float uptime_s = std::chrono::duration<float>(uptime).count();
+        const float float_step_ms = (std::nextafter(uptime_s, std::numeric_limits<float>::max()) - uptime_s) * 1000.0f;
+        std::cout << "start " << configuration.start << " s, end " << configuration.end << " s: " << edges << " edges, "
+            << errors << " off the grid (float seconds would step by " << float_step_ms << " ms at this uptime)" << std::endl;
+        return errors == 0 && edges > 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int weeks = argc > 1 ? std::atoi(argv[1]) : 6;
+    const nanoseconds uptime = std::chrono::weeks(weeks);
+    if (weeks <= 0)
+    {
+        std::cout << "Usage: timer_soak [weeks]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Periods that are not whole milliseconds, or not representable in binary, are the ones that drifted
+    const std::vector<Configuration> configurations = {
+        { 0.1f, 0.35f },
+        { 0.3333f, 0.7777f },
+        { 1.7f, 3.3f },
+        { 59.9f, 60.1f },
+        { 600.5f, 3600.25f }
+    };
+
+    std::cout << "Soaking " << configurations.size() << " schedules over " << weeks << " weeks of uptime." << std::endl;
+    std::mt19937 rng(7);
+    bool exact = true;
+    for (const Configuration& configuration : configurations)
+    {
+        exact = soak(configuration, uptime, rng) && exact;
+    }
+    return exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,105 @@
+// Times advancing the timer's TimingWheel by one 1 ms tick with 10, 1k and 100k pending transitions.
+// Every transition belongs to a periodic schedule and inserts its next edge when it fires, as the
+// timer's schedules do, so the number of pending transitions stays constant. Checks that every
+// edge fires exactly at its tick and that none is missed.
+//
+// Not part of LedStripApp.vcxproj, build it from LedStripApp/src:
+//   cl /std:c++20 /EHsc /O2 /I. ..\tools\timing_wheel_bench.cpp
+//   g++ -std=c++20 -O2 -I. ../tools/timing_wheel_bench.cpp
+//
+// Usage: timing_wheel_bench [seconds] [transitions...], default 600 s of ticks and 10 1000 100000
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include "timing_wheel.h"
+
+namespace
+{
+    struct Transition
+    {
+        uint32_t schedule = 0;
+        uint64_t due = 0;
+    };
+
+    struct Schedule
+    {
+        uint64_t phase; // First edge, in ticks
+        uint64_t period;
+    };
+
+    bool run(size_t count, uint64_t ticks)
+    {
+        // Periods spread evenly on a log scale from 50 ms to 2 hours, so every level of the wheel holds edges
+        std::mt19937_64 rng(count);
+        std::uniform_real_distribution<double> log_period(std::log(50.0), std::log(2.0 * 60 * 60 * 1000));
+        std::vector<Schedule> schedules;
+        TimingWheel<Transition> wheel;
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint64_t period = static_cast<uint64_t>(std::exp(log_period(rng)));
+            const Schedule schedule = { 1 + rng() % period, period };
+            schedules.push_back(schedule);
+            wheel.insert(schedule.phase, { static_cast<uint32_t>(i), schedule.phase });
+        }
+
+        uint64_t fired = 0;
+        uint64_t late = 0;
+        uint64_t now = 0;
+        auto fire = [&](Transition transition) {
+            fired++;
+            late += transition.due != now ? 1 : 0;
+            const uint64_t next = transition.due + schedules[transition.schedule].period;
+            wheel.insert(next, { transition.schedule, next });
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        for (now = 1; now <= ticks; now++)
+        {
+            wheel.advance(now, fire);
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        uint64_t expected = 0;
+        for (const Schedule& schedule : schedules)
+        {
+            expected += schedule.phase <= ticks ? (ticks - schedule.phase) / schedule.period + 1 : 0;
+        }
+
+        std::cout << count << " pending transitions: " << elapsed.count() / static_cast<double>(ticks) << " ns per tick, "
+            << fired << " fired over " << ticks << " ticks, " << elapsed.count() / static_cast<double>(std::max<uint64_t>(fired, 1)) << " ns per fired edge" << std::endl;
+        if (fired != expected || late != 0 || wheel.size() != count)
+        {
+            std::cout << "Expected " << expected << " edges, " << late << " fired at the wrong tick, " << wheel.size() << " pending." << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint64_t ticks = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 600) * 1000;
+    std::vector<size_t> counts;
+    for (int i = 2; i < argc; i++)
+    {
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (counts.empty())
+    {
+        counts = { 10, 1000, 100000 };
+    }
+
+    bool matched = true;
+    for (size_t count : counts)
+    {
+        matched = run(count, ticks) && matched;
+    }
+    return matched ? EXIT_SUCCESS : EXIT_FAILURE;
+}